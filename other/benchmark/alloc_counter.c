@@ -0,0 +1,91 @@
+/*
+ * LD_PRELOAD shim that counts heap allocations made by the simulation.
+ *
+ * Every malloc-family call is forwarded to glibc's implementation and
+ * counted. At process exit the totals are written to the file named by
+ * the ZF_ALLOC_COUNTER_OUT environment variable (or stderr if unset) as
+ * "allocations <n>" / "allocated_bytes <n>" lines, which
+ * run_benchmarks.py divides by the number of simulated events.
+ *
+ * C++ operator new goes through malloc in libstdc++, so it is covered too.
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+#define _GNU_SOURCE
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+static atomic_ullong allocations;
+static atomic_ullong allocatedBytes;
+
+static inline void count(size_t size)
+{
+    atomic_fetch_add_explicit(&allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&allocatedBytes, size, memory_order_relaxed);
+}
+
+void *malloc(size_t size)
+{
+    count(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count_, size_t size)
+{
+    count(count_ * size);
+    return __libc_calloc(count_, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    count(size);
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    count(size);
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    count(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    count(size);
+    void *result = __libc_memalign(alignment, size);
+    if (result == NULL)
+        return ENOMEM;
+    *ptr = result;
+    return 0;
+}
+
+__attribute__((destructor))
+static void reportAllocations(void)
+{
+    const char *path = getenv("ZF_ALLOC_COUNTER_OUT");
+    FILE *out = path != NULL && *path != '\0' ? fopen(path, "w") : stderr;
+    if (out == NULL)
+        return;
+    fprintf(out, "allocations %llu\nallocated_bytes %llu\n",
+            (unsigned long long)atomic_load(&allocations),
+            (unsigned long long)atomic_load(&allocatedBytes));
+    if (out != stderr)
+        fclose(out);
+}
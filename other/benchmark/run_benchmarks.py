@@ -0,0 +1,236 @@
+# Simulator performance regression benchmarks.
+#
+# Runs the fixed, seeded scenarios in simulations/benchmark/benchmark.ini
+# with Cmdenv and records, per scenario:
+#
+#   events_per_sec     simulated events divided by wall time
+#   wall_time_s        wall clock time of the whole run (setup included)
+#   peak_rss_kib       peak resident set size of the simulation process
+#   allocs_per_event   heap allocations divided by simulated events
+#
+# The results are compared against a stored baseline (JSON) and the script
+# exits with a non-zero status if any metric regressed by more than its
+# tolerance. Use --update-baseline on a known-good build to (re)create the
+# baseline. Wall time, events/sec and memory depend on the machine, so no
+# baseline is shipped: create one on each machine before comparing; without
+# it the script only reports the results.
+#
+# Allocations are counted by preloading libzfalloccounter.so (see the
+# Makefile next to this script). It is built on demand if missing.
+#
+# Usage (from the project root):
+#   python3 other/benchmark/run_benchmarks.py
+#   python3 other/benchmark/run_benchmarks.py --update-baseline
+#   python3 other/benchmark/run_benchmarks.py -s BenchOurMethod --tolerance events_per_sec=0.05
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+PROJECT_DIR = os.path.abspath(os.path.join(SCRIPT_DIR, "..", ".."))
+SIMULATIONS_DIR = os.path.join(PROJECT_DIR, "simulations")
+
+SCENARIOS = [
+    "BenchAutomaticTsn",
+    "BenchOurMethod",
+    "BenchSipHash",
+    "BenchChaChaPoly",
+    "BenchScaled",
+]
+
+# Maximum allowed relative regression per metric. For events_per_sec a
+# regression is a decrease, for all other metrics it is an increase.
+DEFAULT_TOLERANCES = {
+    "events_per_sec": 0.10,
+    "wall_time_s": 0.10,
+    "peak_rss_kib": 0.10,
+    "allocs_per_event": 0.05,
+}
+
+HIGHER_IS_BETTER = {"events_per_sec"}
+
+# Cmdenv prints e.g. "<!> Simulation time limit reached -- at t=0.1s, event #123456"
+EVENT_COUNT_PATTERN = re.compile(r"event #(\d+)")
+
+
+def build_alloc_counter():
+    library = os.path.join(SCRIPT_DIR, "libzfalloccounter.so")
+    if not os.path.exists(library):
+        subprocess.run(["make", "-C", SCRIPT_DIR], check=True, stdout=subprocess.DEVNULL)
+    return library
+
+
+def run_scenario(args, scenario, alloc_counter):
+    with tempfile.NamedTemporaryFile(prefix="zf-allocs-", suffix=".txt", delete=False) as f:
+        alloc_output = f.name
+
+    # Only the simulation itself is preloaded, not the helper process below,
+    # which would otherwise overwrite the counts when it exits.
+    preload = []
+    if alloc_counter is not None:
+        preload = ["env", f"LD_PRELOAD={alloc_counter}", f"ZF_ALLOC_COUNTER_OUT={alloc_output}"]
+
+    command = preload + [
+        args.executable,
+        "-u", "Cmdenv",
+        "-f", "benchmark/benchmark.ini",
+        "-c", scenario,
+        "-r", "0",
+        "-n", args.ned_path,
+    ]
+    # RUSAGE_CHILDREN reports the maximum over all waited-for children, so
+    # every scenario runs in a fresh helper process to keep peak RSS per run.
+    rusage_wrapper = [
+        sys.executable, "-c",
+        "import resource, subprocess, sys; "
+        "code = subprocess.call(sys.argv[1:]); "
+        "print('__peak_rss_kib', resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss, file=sys.stderr); "
+        "sys.exit(code)",
+    ]
+
+    start = time.perf_counter()
+    result = subprocess.run(rusage_wrapper + command, cwd=SIMULATIONS_DIR,
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    wall_time = time.perf_counter() - start
+
+    if result.returncode != 0:
+        sys.stderr.write(result.stdout)
+        sys.stderr.write(result.stderr)
+        raise RuntimeError(f"{scenario}: simulation exited with status {result.returncode}")
+
+    event_counts = EVENT_COUNT_PATTERN.findall(result.stdout)
+    if not event_counts:
+        raise RuntimeError(f"{scenario}: could not find the final event count in the Cmdenv output")
+    events = int(event_counts[-1])
+
+    peak_rss = None
+    for line in result.stderr.splitlines():
+        if line.startswith("__peak_rss_kib"):
+            peak_rss = int(line.split()[1])
+
+    allocations = None
+    if alloc_counter is not None:
+        with open(alloc_output) as f:
+            for line in f:
+                key, value = line.split()
+                if key == "allocations":
+                    allocations = int(value)
+    os.unlink(alloc_output)
+
+    return {
+        "events": events,
+        "events_per_sec": events / wall_time,
+        "wall_time_s": wall_time,
+        "peak_rss_kib": peak_rss,
+        "allocs_per_event": allocations / events if allocations is not None and events > 0 else None,
+    }
+
+
+def best_of(runs):
+    # Take the fastest repetition; memory metrics are deterministic for a
+    # seeded run, so they are taken from the same repetition.
+    return min(runs, key=lambda run: run["wall_time_s"])
+
+
+def compare(scenario, measured, baseline, tolerances):
+    regressions = []
+    for metric, tolerance in tolerances.items():
+        value = measured.get(metric)
+        reference = baseline.get(metric)
+        if value is None or reference is None or reference == 0:
+            continue
+        change = (value - reference) / reference
+        if metric in HIGHER_IS_BETTER:
+            regressed = change < -tolerance
+        else:
+            regressed = change > tolerance
+        status = "REGRESSION" if regressed else "ok"
+        print(f"  {metric:<18} {value:>14.3f}  baseline {reference:>14.3f}  {change:+8.2%}  (tolerance {tolerance:.0%})  {status}")
+        if regressed:
+            regressions.append(f"{scenario}.{metric}")
+    return regressions
+
+
+def parse_tolerances(overrides, stored):
+    tolerances = dict(DEFAULT_TOLERANCES)
+    tolerances.update(stored)
+    for override in overrides:
+        metric, _, value = override.partition("=")
+        if metric not in DEFAULT_TOLERANCES:
+            raise SystemExit(f"unknown metric '{metric}', expected one of {', '.join(DEFAULT_TOLERANCES)}")
+        tolerances[metric] = float(value)
+    return tolerances
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the simulator performance benchmarks.")
+    parser.add_argument("-s", "--scenario", action="append", choices=SCENARIOS,
+                        help="scenario to run (default: all); may be repeated")
+    parser.add_argument("--executable", default=os.path.join(PROJECT_DIR, "src", "zonalfilterexec"),
+                        help="simulation executable (default: src/zonalfilterexec)")
+    parser.add_argument("--ned-path", default=".:../src:../../inet4.5/src",
+                        help="NED path, relative to the simulations directory")
+    parser.add_argument("--baseline", default=os.path.join(SIMULATIONS_DIR, "benchmark", "baseline.json"),
+                        help="baseline file (default: simulations/benchmark/baseline.json)")
+    parser.add_argument("--update-baseline", action="store_true",
+                        help="store the measured results as the new baseline instead of comparing")
+    parser.add_argument("--tolerance", action="append", default=[], metavar="METRIC=FRACTION",
+                        help="override the allowed relative regression of a metric, e.g. events_per_sec=0.05")
+    parser.add_argument("--repeat", type=int, default=3,
+                        help="repetitions per scenario, the fastest one is kept (default: 3)")
+    parser.add_argument("--no-alloc-counter", action="store_true",
+                        help="do not preload the allocation counter (allocs_per_event is not measured)")
+    parser.add_argument("-o", "--output", help="also write the measured results to this JSON file")
+    args = parser.parse_args()
+
+    scenarios = args.scenario or SCENARIOS
+    alloc_counter = None if args.no_alloc_counter else build_alloc_counter()
+
+    baseline = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    elif not args.update_baseline:
+        print(f"No baseline at {args.baseline}, only reporting results (use --update-baseline to create one).")
+    tolerances = parse_tolerances(args.tolerance, baseline.get("tolerances", {}))
+
+    results = {}
+    regressions = []
+    for scenario in scenarios:
+        runs = [run_scenario(args, scenario, alloc_counter) for _ in range(max(1, args.repeat))]
+        results[scenario] = best_of(runs)
+        print(f"{scenario}: {results[scenario]['events']} events")
+        if scenario in baseline.get("scenarios", {}) and not args.update_baseline:
+            regressions += compare(scenario, results[scenario], baseline["scenarios"][scenario], tolerances)
+        else:
+            for metric in DEFAULT_TOLERANCES:
+                value = results[scenario][metric]
+                if value is not None:
+                    print(f"  {metric:<18} {value:>14.3f}")
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump({"scenarios": results}, f, indent=4)
+
+    if args.update_baseline:
+        stored = baseline.get("scenarios", {})
+        stored.update(results)
+        with open(args.baseline, "w") as f:
+            json.dump({"tolerances": baseline.get("tolerances", {}), "scenarios": stored}, f, indent=4)
+        print(f"Baseline written to {args.baseline}")
+        return 0
+
+    if regressions:
+        print("Performance regressions: " + ", ".join(regressions))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,542 @@
+//
+// Real-traffic benchmark of the zonal firewall rule engine.
+//
+// Runs FirewallRuleEngine (src/zonalfilter/firewall/engine) on frames that
+// carry a type ID header, either in memory ("engine" mode) or received from
+// a Linux interface through an AF_PACKET TPACKET_V3 ring ("afpacket" mode).
+// "classifier" mode compares the classifier backends of the engine on a
+// rule set (see generate_rules.py): build time, memory and lookups/sec.
+// In afpacket mode the frames can be generated on the other end of a veth
+// pair by the same process (batched sendmmsg), so the benchmark needs no
+// external hardware:
+//
+//   sudo ./setup_veth.sh up
+//   sudo ./firewall_bench --mode afpacket --rules example.rules --tx veth-zf0 --rx veth-zf1
+//
+// Frame format (all fields big endian):
+//
+//   dst MAC (6) | src MAC (6) | EtherType 0x88B5 (2) | type ID (2) | port (2) | padding
+//
+// The type ID is the engine's ID of the message type, and the port selects
+// which of the rule file's interfaces the frame is checked against, so one
+// veth pair can exercise all ports of a zonal gateway.
+//
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+
+#include "zonalfilter/firewall/engine/FirewallRuleEngine.h"
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint16_t ETHERTYPE_ZONAL_TYPE = 0x88B5; // IEEE local experimental EtherType
+static const size_t TYPE_HEADER_OFFSET = 14;
+static const size_t MIN_FRAME_SIZE = TYPE_HEADER_OFFSET + 4;
+
+struct Options {
+    std::string mode = "engine";
+    std::string rulesFile;
+    std::string txInterface;
+    std::string rxInterface;
+    std::vector<std::string> classifiers;
+    std::string csvFile;
+    FirewallRuleEngine::Direction direction = FirewallRuleEngine::OUT;
+    double seconds = 5;
+    size_t frameSize = 60;
+    size_t batchSize = 64;
+    size_t numTemplates = 4096;
+    double unknownRatio = 0.1;
+    uint32_t blockSize = 1 << 22;
+    uint32_t numBlocks = 64;
+    unsigned seed = 0;
+};
+
+struct Counters {
+    uint64_t frames = 0;
+    uint64_t accepted = 0;
+    uint64_t dropped = 0;
+    uint64_t malformed = 0;
+};
+
+static void usage(const char *program)
+{
+    std::fprintf(stderr,
+            "usage: %s --rules FILE [options]\n"
+            "  --mode engine|afpacket|classifier\n"
+            "                           in-memory frames, AF_PACKET receive or classifier comparison (default: engine)\n"
+            "  --rules FILE             rule file, see example.rules\n"
+            "  --classifier NAME[,...]  classifier backend(s): linear, hash, tree (default: linear; all in classifier mode)\n"
+            "  --direction in|out       rule direction to check (default: out, i.e. ingress filter)\n"
+            "  --seconds S              measurement duration (default: 5)\n"
+            "  --frame-size BYTES       generated frame size without FCS (default: 60)\n"
+            "  --unknown-ratio R        fraction of frames with a type not in the rules (default: 0.1)\n"
+            "  --seed N                 traffic mix seed (default: 0)\n"
+            "afpacket mode:\n"
+            "  --rx IFACE               interface to receive and filter on\n"
+            "  --tx IFACE               interface to generate traffic on (omit to use an external source)\n"
+            "  --batch N                frames per sendmmsg() call (default: 64)\n"
+            "  --block-size BYTES       TPACKET_V3 block size (default: 4194304)\n"
+            "  --blocks N               TPACKET_V3 number of blocks (default: 64)\n"
+            "classifier mode:\n"
+            "  --csv FILE               append the results to a CSV file\n",
+            program);
+    std::exit(1);
+}
+
+static Options parseOptions(int argc, char **argv)
+{
+    static const option longOptions[] = {
+        {"mode", required_argument, nullptr, 'm'},
+        {"rules", required_argument, nullptr, 'r'},
+        {"direction", required_argument, nullptr, 'd'},
+        {"seconds", required_argument, nullptr, 's'},
+        {"frame-size", required_argument, nullptr, 'f'},
+        {"unknown-ratio", required_argument, nullptr, 'u'},
+        {"seed", required_argument, nullptr, 'S'},
+        {"rx", required_argument, nullptr, 'R'},
+        {"tx", required_argument, nullptr, 'T'},
+        {"batch", required_argument, nullptr, 'b'},
+        {"block-size", required_argument, nullptr, 'B'},
+        {"blocks", required_argument, nullptr, 'n'},
+        {"classifier", required_argument, nullptr, 'c'},
+        {"csv", required_argument, nullptr, 'C'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    Options options;
+    int c;
+    while ((c = getopt_long(argc, argv, "h", longOptions, nullptr)) != -1) {
+        switch (c) {
+            case 'm': options.mode = optarg; break;
+            case 'r': options.rulesFile = optarg; break;
+            case 'd': options.direction = std::strcmp(optarg, "in") == 0 ? FirewallRuleEngine::IN : FirewallRuleEngine::OUT; break;
+            case 's': options.seconds = std::atof(optarg); break;
+            case 'f': options.frameSize = std::strtoul(optarg, nullptr, 10); break;
+            case 'u': options.unknownRatio = std::atof(optarg); break;
+            case 'S': options.seed = std::strtoul(optarg, nullptr, 10); break;
+            case 'R': options.rxInterface = optarg; break;
+            case 'T': options.txInterface = optarg; break;
+            case 'b': options.batchSize = std::strtoul(optarg, nullptr, 10); break;
+            case 'B': options.blockSize = std::strtoul(optarg, nullptr, 10); break;
+            case 'n': options.numBlocks = std::strtoul(optarg, nullptr, 10); break;
+            case 'c': {
+                std::istringstream names(optarg);
+                for (std::string name; std::getline(names, name, ',');)
+                    options.classifiers.push_back(name);
+                break;
+            }
+            case 'C': options.csvFile = optarg; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (options.rulesFile.empty() || (options.mode != "engine" && options.mode != "afpacket" && options.mode != "classifier"))
+        usage(argv[0]);
+    if (options.classifiers.empty()) {
+        if (options.mode == "classifier")
+            options.classifiers = FirewallRuleEngine::getClassifierNames();
+        else
+            options.classifiers.push_back("linear");
+    }
+    if (options.mode == "afpacket" && options.rxInterface.empty())
+        usage(argv[0]);
+    if (options.frameSize < MIN_FRAME_SIZE)
+        options.frameSize = MIN_FRAME_SIZE;
+    return options;
+}
+
+// Parses a numeric type ID (decimal or 0x hex) below the frame's reserved
+// unknown type 0xffff.
+static FirewallRuleEngine::TypeId parseTypeId(const std::string& text)
+{
+    size_t end;
+    unsigned long type = std::stoul(text, &end, 0);
+    if (end != text.size() || type >= 0xffff)
+        throw std::runtime_error("invalid type ID " + text);
+    return type;
+}
+
+// Reads "<interface> <in|out> [<type> ...]" lines; returns the interfaces in
+// file order (the frame's port field indexes this list). A type is a name,
+// which gets the next free ID, a numeric ID, or a range of IDs "<first>-<last>".
+static std::vector<FirewallRuleEngine::InterfaceId> loadRules(const std::string& fileName, FirewallRuleEngine& engine)
+{
+    std::ifstream file(fileName);
+    if (!file)
+        throw std::runtime_error("cannot open rule file " + fileName);
+    std::vector<FirewallRuleEngine::InterfaceId> ports;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string interfaceName, direction;
+        if (!(fields >> interfaceName))
+            continue;
+        if (!(fields >> direction) || (direction != "in" && direction != "out"))
+            throw std::runtime_error("invalid rule line: " + line);
+        auto ruleDirection = direction == "in" ? FirewallRuleEngine::IN : FirewallRuleEngine::OUT;
+        std::vector<std::string> types;
+        std::vector<std::pair<FirewallRuleEngine::TypeId, FirewallRuleEngine::TypeId>> typeRanges;
+        for (std::string type; fields >> type;) {
+            if (!std::isdigit((unsigned char)type[0]))
+                types.push_back(type);
+            else {
+                auto dash = type.find('-');
+                auto first = parseTypeId(type.substr(0, dash));
+                auto last = dash == std::string::npos ? first : parseTypeId(type.substr(dash + 1));
+                typeRanges.emplace_back(first, last);
+            }
+        }
+        size_t numInterfaces = engine.getNumInterfaces();
+        auto interface = engine.addInterface(interfaceName);
+        if (engine.getNumInterfaces() != numInterfaces)
+            ports.push_back(interface);
+        engine.setAllowedTypes(interfaceName, ruleDirection, types);
+        for (const auto& range : typeRanges)
+            engine.addAllowedTypes(interfaceName, ruleDirection, range.first, range.second);
+    }
+    return ports;
+}
+
+static std::vector<std::vector<uint8_t>> generateFrames(const Options& options, const FirewallRuleEngine& engine, size_t numPorts)
+{
+    std::mt19937 random(options.seed);
+    std::uniform_int_distribution<uint32_t> portDistribution(0, numPorts - 1);
+    std::uniform_int_distribution<uint32_t> typeDistribution(0, engine.getTypeLimit() > 0 ? engine.getTypeLimit() - 1 : 0);
+    std::bernoulli_distribution unknownDistribution(options.unknownRatio);
+    std::vector<std::vector<uint8_t>> frames(options.numTemplates);
+    for (auto& frame : frames) {
+        frame.assign(options.frameSize, 0);
+        std::memset(frame.data(), 0xff, 6);                     // broadcast destination
+        const uint8_t source[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+        std::memcpy(frame.data() + 6, source, 6);               // locally administered source
+        uint16_t etherType = htons(ETHERTYPE_ZONAL_TYPE);
+        uint16_t type = htons(unknownDistribution(random) || engine.getTypeLimit() == 0 ? 0xffff : typeDistribution(random));
+        uint16_t port = htons(portDistribution(random));
+        std::memcpy(frame.data() + 12, &etherType, 2);
+        std::memcpy(frame.data() + TYPE_HEADER_OFFSET, &type, 2);
+        std::memcpy(frame.data() + TYPE_HEADER_OFFSET + 2, &port, 2);
+    }
+    return frames;
+}
+
+static inline void filterFrame(const uint8_t *frame, size_t length, const FirewallRuleEngine& engine,
+        const std::vector<FirewallRuleEngine::InterfaceId>& ports, FirewallRuleEngine::Direction direction, Counters& counters)
+{
+    counters.frames++;
+    uint16_t etherType, type, port;
+    if (length < MIN_FRAME_SIZE)
+        goto malformed;
+    std::memcpy(&etherType, frame + 12, 2);
+    if (ntohs(etherType) != ETHERTYPE_ZONAL_TYPE)
+        goto malformed;
+    std::memcpy(&type, frame + TYPE_HEADER_OFFSET, 2);
+    std::memcpy(&port, frame + TYPE_HEADER_OFFSET + 2, 2);
+    type = ntohs(type);
+    port = ntohs(port);
+    if (port >= ports.size())
+        goto malformed;
+    if (engine.check(ports[port], direction, type == 0xffff ? FirewallRuleEngine::UNKNOWN : type))
+        counters.accepted++;
+    else
+        counters.dropped++;
+    return;
+  malformed:
+    counters.malformed++;
+}
+
+static void report(const char *what, const Counters& counters, double seconds)
+{
+    std::printf("%s: %llu frames in %.3f s = %.3f Mpps (accepted %llu, dropped %llu, malformed %llu)\n",
+            what, (unsigned long long)counters.frames, seconds, counters.frames / seconds / 1e6,
+            (unsigned long long)counters.accepted, (unsigned long long)counters.dropped, (unsigned long long)counters.malformed);
+}
+
+static int runEngine(const Options& options, const FirewallRuleEngine& engine, const std::vector<FirewallRuleEngine::InterfaceId>& ports)
+{
+    auto frames = generateFrames(options, engine, ports.size());
+    Counters counters;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration<double>(options.seconds);
+    while (std::chrono::steady_clock::now() < deadline)
+        for (const auto& frame : frames)
+            filterFrame(frame.data(), frame.size(), engine, ports, options.direction, counters);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("engine", counters, elapsed);
+    return 0;
+}
+
+// Measures every classifier backend on the same lookups, which are drawn
+// like the generated frames but over all interfaces and both directions.
+static int runClassifiers(const Options& options, FirewallRuleEngine& engine)
+{
+    struct Lookup {
+        FirewallRuleEngine::InterfaceId interface;
+        FirewallRuleEngine::Direction direction;
+        FirewallRuleEngine::TypeId type;
+    };
+    std::mt19937 random(options.seed);
+    std::uniform_int_distribution<uint32_t> interfaceDistribution(0, engine.getNumInterfaces() - 1);
+    std::uniform_int_distribution<uint32_t> typeDistribution(0, engine.getTypeLimit() > 0 ? engine.getTypeLimit() - 1 : 0);
+    std::bernoulli_distribution unknownDistribution(options.unknownRatio);
+    std::vector<Lookup> lookups(1 << 20);
+    for (auto& lookup : lookups) {
+        lookup.interface = interfaceDistribution(random);
+        lookup.direction = random() & 1 ? FirewallRuleEngine::IN : FirewallRuleEngine::OUT;
+        lookup.type = unknownDistribution(random) || engine.getTypeLimit() == 0 ? FirewallRuleEngine::UNKNOWN : typeDistribution(random);
+    }
+
+    FILE *csv = nullptr;
+    if (!options.csvFile.empty()) {
+        csv = std::fopen(options.csvFile.c_str(), "a");
+        if (csv == nullptr)
+            throw std::runtime_error("cannot open " + options.csvFile);
+        if (std::ftell(csv) == 0)
+            std::fprintf(csv, "rules_file,interfaces,type_limit,rules,classifier,build_ms,memory_bytes,lookups_per_sec\n");
+    }
+
+    // The linear backend is the reference: every backend must make the same
+    // decision for every interface, direction and type, and for unknown types.
+    auto forEachDecision = [&] (auto visit) {
+        size_t index = 0;
+        for (FirewallRuleEngine::InterfaceId interface = 0; interface < engine.getNumInterfaces(); interface++)
+            for (auto direction : { FirewallRuleEngine::IN, FirewallRuleEngine::OUT })
+                for (uint64_t type = 0; type <= engine.getTypeLimit(); type++)
+                    if (!visit(index++, interface, direction, type < engine.getTypeLimit() ? (FirewallRuleEngine::TypeId)type : FirewallRuleEngine::UNKNOWN))
+                        return;
+    };
+    engine.build("linear");
+    std::vector<uint8_t> reference;
+    reference.reserve(engine.getNumInterfaces() * 2 * ((size_t)engine.getTypeLimit() + 1));
+    forEachDecision([&] (size_t, FirewallRuleEngine::InterfaceId interface, FirewallRuleEngine::Direction direction, FirewallRuleEngine::TypeId type) {
+        reference.push_back(engine.check(interface, direction, type));
+        return true;
+    });
+
+    std::printf("%-8s %12s %14s %16s\n", "backend", "build [ms]", "memory [KiB]", "lookups/s");
+    int status = 0;
+    for (const auto& name : options.classifiers) {
+        auto buildStart = std::chrono::steady_clock::now();
+        engine.build(name);
+        double buildTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count();
+
+        forEachDecision([&] (size_t index, FirewallRuleEngine::InterfaceId interface, FirewallRuleEngine::Direction direction, FirewallRuleEngine::TypeId type) {
+            bool accepted = engine.check(interface, direction, type);
+            if (accepted == (bool)reference[index])
+                return true;
+            std::fprintf(stderr, "firewall_bench: %s %s interface %u %s type %u, linear %s\n", name.c_str(), accepted ? "accepts" : "drops",
+                    interface, direction == FirewallRuleEngine::IN ? "in" : "out", type, accepted ? "drops" : "accepts");
+            status = 1;
+            return false;
+        });
+
+        uint64_t numLookups = 0;
+        volatile long sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::duration<double>(options.seconds);
+        while (std::chrono::steady_clock::now() < deadline) {
+            long passes = 0;
+            for (const auto& lookup : lookups)
+                passes += engine.check(lookup.interface, lookup.direction, lookup.type);
+            sink = sink + passes;
+            numLookups += lookups.size();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t memory = engine.getClassifier()->getMemoryUsage();
+        std::printf("%-8s %12.3f %14.1f %16.0f\n", name.c_str(), buildTime * 1e3, memory / 1024.0, numLookups / elapsed);
+        if (csv != nullptr)
+            std::fprintf(csv, "%s,%zu,%u,%zu,%s,%.3f,%zu,%.0f\n", options.rulesFile.c_str(), engine.getNumInterfaces(), engine.getTypeLimit(),
+                    engine.getNumRules(), name.c_str(), buildTime * 1e3, memory, numLookups / elapsed);
+    }
+    if (csv != nullptr)
+        std::fclose(csv);
+    return status;
+}
+
+static int openPacketSocket(const std::string& interfaceName, uint16_t protocol, int& interfaceIndex)
+{
+    interfaceIndex = if_nametoindex(interfaceName.c_str());
+    if (interfaceIndex == 0)
+        throw std::runtime_error("unknown interface " + interfaceName);
+    int fd = socket(AF_PACKET, SOCK_RAW, htons(protocol));
+    if (fd < 0)
+        throw std::runtime_error(std::string("socket(AF_PACKET): ") + std::strerror(errno) + " (needs CAP_NET_RAW)");
+    return fd;
+}
+
+static void bindPacketSocket(int fd, int interfaceIndex, uint16_t protocol)
+{
+    sockaddr_ll address = {};
+    address.sll_family = AF_PACKET;
+    address.sll_protocol = htons(protocol);
+    address.sll_ifindex = interfaceIndex;
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        throw std::runtime_error(std::string("bind(AF_PACKET): ") + std::strerror(errno));
+}
+
+// Runs on the transmitter thread; the socket is opened by the caller, so
+// that setup errors are reported before the thread starts.
+static void transmit(const Options& options, int fd, int interfaceIndex, const std::vector<std::vector<uint8_t>>& frames, std::atomic<bool>& running, Counters& counters)
+{
+    sockaddr_ll destination = {};
+    destination.sll_family = AF_PACKET;
+    destination.sll_ifindex = interfaceIndex;
+    destination.sll_halen = 6;
+    std::memset(destination.sll_addr, 0xff, 6);
+
+    std::vector<iovec> iovecs(options.batchSize);
+    std::vector<mmsghdr> messages(options.batchSize);
+    size_t next = 0;
+    while (running.load(std::memory_order_relaxed)) {
+        for (size_t i = 0; i < options.batchSize; i++) {
+            auto& frame = frames[next++ % frames.size()];
+            iovecs[i].iov_base = const_cast<uint8_t *>(frame.data());
+            iovecs[i].iov_len = frame.size();
+            messages[i] = {};
+            messages[i].msg_hdr.msg_name = &destination;
+            messages[i].msg_hdr.msg_namelen = sizeof(destination);
+            messages[i].msg_hdr.msg_iov = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        // a full TX queue (ENOBUFS) just means we generate faster than the veth can take
+        int sent = sendmmsg(fd, messages.data(), options.batchSize, 0);
+        if (sent > 0)
+            counters.frames += sent;
+        else if (sent < 0 && errno != ENOBUFS && errno != EAGAIN)
+            throw std::runtime_error(std::string("sendmmsg: ") + std::strerror(errno));
+    }
+}
+
+static int runAfPacket(const Options& options, const FirewallRuleEngine& engine, const std::vector<FirewallRuleEngine::InterfaceId>& ports)
+{
+    int interfaceIndex;
+    int fd = openPacketSocket(options.rxInterface, ETHERTYPE_ZONAL_TYPE, interfaceIndex);
+
+    int version = TPACKET_V3;
+    if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+        throw std::runtime_error(std::string("PACKET_VERSION: ") + std::strerror(errno));
+    tpacket_req3 request = {};
+    request.tp_block_size = options.blockSize;
+    request.tp_block_nr = options.numBlocks;
+    request.tp_frame_size = 2048;
+    request.tp_frame_nr = options.blockSize / request.tp_frame_size * options.numBlocks;
+    request.tp_retire_blk_tov = 10; // ms, flushes partially filled blocks at low rates
+    if (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) < 0)
+        throw std::runtime_error(std::string("PACKET_RX_RING: ") + std::strerror(errno));
+    size_t ringSize = (size_t)options.blockSize * options.numBlocks;
+    auto ring = static_cast<uint8_t *>(mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    if (ring == MAP_FAILED)
+        throw std::runtime_error(std::string("mmap: ") + std::strerror(errno));
+    bindPacketSocket(fd, interfaceIndex, ETHERTYPE_ZONAL_TYPE);
+
+    std::atomic<bool> transmitting(true);
+    Counters txCounters;
+    std::thread transmitter;
+    std::exception_ptr transmitError;
+    int txFd = -1;
+    if (!options.txInterface.empty()) {
+        auto frames = generateFrames(options, engine, ports.size());
+        int txInterfaceIndex;
+        txFd = openPacketSocket(options.txInterface, 0, txInterfaceIndex);
+        bindPacketSocket(txFd, txInterfaceIndex, 0);
+        int one = 1;
+        setsockopt(txFd, SOL_PACKET, PACKET_QDISC_BYPASS, &one, sizeof(one));
+        // an exception must not leave the thread, it is rethrown after join()
+        transmitter = std::thread([&options, txFd, txInterfaceIndex, frames, &transmitting, &txCounters, &transmitError] () {
+            try {
+                transmit(options, txFd, txInterfaceIndex, frames, transmitting, txCounters);
+            }
+            catch (...) {
+                transmitError = std::current_exception();
+            }
+        });
+    }
+
+    // Whole blocks are handed over by the kernel, so the per-frame cost is
+    // just the header walk and the rule check.
+    Counters rxCounters;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration<double>(options.seconds);
+    uint32_t blockIndex = 0;
+    while (std::chrono::steady_clock::now() < deadline) {
+        auto block = reinterpret_cast<tpacket_block_desc *>(ring + (size_t)blockIndex * options.blockSize);
+        if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+            pollfd pfd = {fd, POLLIN | POLLERR, 0};
+            poll(&pfd, 1, 10);
+            continue;
+        }
+        auto packet = reinterpret_cast<tpacket3_hdr *>(reinterpret_cast<uint8_t *>(block) + block->hdr.bh1.offset_to_first_pkt);
+        for (uint32_t i = 0; i < block->hdr.bh1.num_pkts; i++) {
+            filterFrame(reinterpret_cast<uint8_t *>(packet) + packet->tp_mac, packet->tp_snaplen, engine, ports, options.direction, rxCounters);
+            packet = reinterpret_cast<tpacket3_hdr *>(reinterpret_cast<uint8_t *>(packet) + packet->tp_next_offset);
+        }
+        __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        blockIndex = (blockIndex + 1) % options.numBlocks;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    transmitting = false;
+    if (transmitter.joinable())
+        transmitter.join();
+    if (txFd >= 0)
+        close(txFd);
+    if (transmitError)
+        std::rethrow_exception(transmitError);
+
+    tpacket_stats_v3 stats = {};
+    socklen_t statsLength = sizeof(stats);
+    getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &stats, &statsLength);
+
+    if (!options.txInterface.empty())
+        std::printf("tx %s: %llu frames = %.3f Mpps\n", options.txInterface.c_str(),
+                (unsigned long long)txCounters.frames, txCounters.frames / elapsed / 1e6);
+    report(("rx " + options.rxInterface).c_str(), rxCounters, elapsed);
+    std::printf("kernel: %u frames received, %u dropped (ring full)\n", stats.tp_packets, stats.tp_drops);
+
+    munmap(ring, ringSize);
+    close(fd);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    try {
+        Options options = parseOptions(argc, argv);
+        FirewallRuleEngine engine;
+        auto ports = loadRules(options.rulesFile, engine);
+        if (ports.empty())
+            throw std::runtime_error("no interfaces in rule file " + options.rulesFile);
+        std::printf("%zu interfaces, %u type IDs, %zu rules\n", ports.size(), engine.getTypeLimit(), engine.getNumRules());
+        if (options.mode == "classifier")
+            return runClassifiers(options, engine);
+        engine.build(options.classifiers[0]);
+        std::printf("classifier %s, frame size %zu B\n", options.classifiers[0].c_str(), options.frameSize);
+        return options.mode == "engine" ? runEngine(options, engine, ports) : runAfPacket(options, engine, ports);
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "firewall_bench: %s\n", e.what());
+        return 1;
+    }
+}
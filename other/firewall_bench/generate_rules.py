@@ -0,0 +1,66 @@
+# Generates large synthetic rule files for firewall_bench.
+#
+# The output uses the example.rules format with numeric type IDs, so the
+# classifier backends can be compared at production rule counts:
+#
+#   <interface> <in|out> <type> ...
+#
+# where <type> is a single ID or a wildcard range "<first>-<last>". Every
+# interface gets rules in both directions; a fraction of the rules are
+# ranges of up to --max-range types, the rest are exact IDs.
+#
+# Usage (from this directory):
+#   python3 generate_rules.py --interfaces 200 --types 5000 --rules-per-interface 100 -o large.rules
+#   ./firewall_bench --mode classifier --rules large.rules
+
+import argparse
+import random
+import sys
+
+
+def generate(args, output):
+    rng = random.Random(args.seed)
+    output.write(f"# generate_rules.py --interfaces {args.interfaces} --types {args.types} "
+                 f"--rules-per-interface {args.rules_per_interface} --range-fraction {args.range_fraction} "
+                 f"--max-range {args.max_range} --seed {args.seed}\n")
+    for interface in range(args.interfaces):
+        for direction in ("in", "out"):
+            tokens = []
+            for _ in range(args.rules_per_interface):
+                first = rng.randrange(args.types)
+                if rng.random() < args.range_fraction:
+                    last = min(args.types - 1, first + rng.randint(1, args.max_range - 1))
+                    tokens.append(f"{first}-{last}")
+                else:
+                    tokens.append(str(first))
+            output.write(f"eth{interface} {direction} {' '.join(tokens)}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a synthetic firewall rule file.")
+    parser.add_argument("--interfaces", type=int, default=100, help="number of interfaces (default: 100)")
+    parser.add_argument("--types", type=int, default=1000, help="number of type IDs, at most 65535 (default: 1000)")
+    parser.add_argument("--rules-per-interface", type=int, default=50,
+                        help="rules per interface and direction (default: 50)")
+    parser.add_argument("--range-fraction", type=float, default=0.1,
+                        help="fraction of rules that are wildcard ranges (default: 0.1)")
+    parser.add_argument("--max-range", type=int, default=64, help="maximum width of a range (default: 64)")
+    parser.add_argument("--seed", type=int, default=1, help="random seed (default: 1)")
+    parser.add_argument("-o", "--output", help="output file (default: stdout)")
+    args = parser.parse_args()
+
+    if not 0 < args.types <= 0xffff:
+        parser.error("--types must be between 1 and 65535")
+    if args.max_range < 2:
+        parser.error("--max-range must be at least 2")
+
+    if args.output:
+        with open(args.output, "w") as f:
+            generate(args, f)
+    else:
+        generate(args, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,67 @@
+# Sweeps rule-set sizes and compares the firewall classifier backends.
+#
+# For each point of the sweep a rule file is generated with
+# generate_rules.py and firewall_bench is run in classifier mode, which
+# appends build time, memory and lookups/sec per backend to the CSV file.
+#
+# Usage (from this directory, after make):
+#   python3 scaling_benchmark.py -o scaling.csv
+#   python3 scaling_benchmark.py --interfaces 10,100,500 --types 5000 --rules-per-interface 200
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+def parse_list(text):
+    return [int(value) for value in text.split(",")]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare the firewall classifier backends over rule-set sizes.")
+    parser.add_argument("--interfaces", type=parse_list, default=[10, 100, 300],
+                        help="comma-separated interface counts (default: 10,100,300)")
+    parser.add_argument("--types", type=parse_list, default=[100, 1000, 5000],
+                        help="comma-separated type ID counts (default: 100,1000,5000)")
+    parser.add_argument("--rules-per-interface", type=parse_list, default=[10, 100, 1000],
+                        help="comma-separated rules per interface and direction (default: 10,100,1000)")
+    parser.add_argument("--range-fraction", type=float, default=0.1,
+                        help="fraction of rules that are wildcard ranges (default: 0.1)")
+    parser.add_argument("--max-range", type=int, default=64, help="maximum width of a range (default: 64)")
+    parser.add_argument("--classifier", default="linear,hash,tree",
+                        help="comma-separated backends (default: linear,hash,tree)")
+    parser.add_argument("--seconds", type=float, default=1.0, help="lookup time per backend (default: 1)")
+    parser.add_argument("-o", "--output", default="scaling.csv", help="CSV file to append to (default: scaling.csv)")
+    args = parser.parse_args()
+
+    bench = os.path.join(SCRIPT_DIR, "firewall_bench")
+    if not os.path.exists(bench):
+        subprocess.run(["make", "-C", SCRIPT_DIR], check=True, stdout=subprocess.DEVNULL)
+
+    status = 0
+    with tempfile.TemporaryDirectory(prefix="zf-rules-") as directory:
+        for interfaces in args.interfaces:
+            for types in args.types:
+                for rules in args.rules_per_interface:
+                    rules_file = os.path.join(directory, f"i{interfaces}-t{types}-r{rules}.rules")
+                    subprocess.run([sys.executable, os.path.join(SCRIPT_DIR, "generate_rules.py"),
+                                    "--interfaces", str(interfaces), "--types", str(types),
+                                    "--rules-per-interface", str(rules),
+                                    "--range-fraction", str(args.range_fraction),
+                                    "--max-range", str(args.max_range), "-o", rules_file], check=True)
+                    print(f"== {interfaces} interfaces, {types} types, {rules} rules per interface and direction",
+                          flush=True)
+                    result = subprocess.run([bench, "--mode", "classifier", "--rules", rules_file,
+                                             "--classifier", args.classifier, "--seconds", str(args.seconds),
+                                             "--csv", args.output])
+                    status = status or result.returncode
+    print(f"Results appended to {args.output}")
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,30 @@
+#!/bin/sh
+#
+# Creates (or with "down", removes) the veth pair used by firewall_bench.
+# Needs root (or CAP_NET_ADMIN).
+#
+# Usage: ./setup_veth.sh [up|down] [name-prefix]
+#
+
+set -e
+prefix=${2:-veth-zf}
+
+case "${1:-up}" in
+up)
+    ip link add "${prefix}0" type veth peer name "${prefix}1"
+    for dev in "${prefix}0" "${prefix}1"; do
+        # keep the kernel from sending its own traffic (IPv6 DAD, router
+        # solicitations) on the benchmark link
+        sysctl -q -w "net.ipv6.conf.${dev}.disable_ipv6=1" || true
+        ip link set "$dev" mtu 1500 up
+    done
+    echo "created ${prefix}0 <-> ${prefix}1"
+    ;;
+down)
+    ip link del "${prefix}0"
+    ;;
+*)
+    echo "usage: $0 [up|down] [name-prefix]" >&2
+    exit 1
+    ;;
+esac
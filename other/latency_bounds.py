@@ -0,0 +1,737 @@
+# Analytical worst-case end-to-end latency bounds (network calculus).
+#
+# Instead of running a full simulation for every design point, this tool
+# reads the topology from a testbed.ned-style network and the traffic from
+# omnetpp.ini, and computes a worst-case end-to-end latency bound for every
+# TypedUdpSourceApp stream. The model follows the simulation as closely as
+# a closed-form analysis allows:
+#
+#  - every stream is a token bucket: one packet (possibly several IP
+#    fragments) per productionInterval
+#  - every egress port is a non-preemptive strict priority scheduler (by
+#    PCP, as assigned by the stream identifier/encoder mappings of the
+#    configuration) with FIFO order inside a priority; its service for a
+#    priority is a rate-latency curve after removing higher priority traffic
+#    and one maximum-size lower priority frame
+#  - with frame preemption (hasFramePreemption and ExpressPcpClassifier),
+#    express priorities are blocked by at most the non-preemptable rest of
+#    a preemptable frame, and every express frame adds the overhead of one
+#    extra fragment to the preemptable priorities below it
+#  - burstiness increases hop by hop (separated flow analysis); the cyclic
+#    dependencies of the zonal ring are resolved by fixed point iteration
+#  - firewalls (FirewallBridgingLayer) add their processing delay once on the
+#    ingress and once on the egress side of every switch traversal
+#  - cryptography (CryptoLayer) adds delay + length / bitrate at the sender
+#    and the receiver, and the trailer length (MAC and freshness value) to
+#    every frame; replay protection adds replayCheckDelay at the receiver
+#  - hop-by-hop MACsec (MacsecEthernetInterface on both ends of a link) adds
+#    the SecTAG and ICV to every frame on the link; the encryption engine
+#    before the egress queue and the decryption engine of the receiving end
+#    each process all frames of the link in order, and are FIFO rate-latency
+#    servers (rate bitrate, latency delay) for the aggregate of its streams
+#
+# Routing is shortest path by hop count, gate schedules are assumed to be
+# always open and clock drift is ignored.
+#
+# Usage (from the project root):
+#   python3 other/latency_bounds.py -c OurMethod --set N=516
+#   python3 other/latency_bounds.py -c AutomaticTsn -c OurMethod -c SipHash -c ChaChaPoly --sweep N -o bounds.csv
+#   python3 other/latency_bounds.py -c ChaChaPoly --override '**.crypto.**.delay=50us'
+#   python3 other/latency_bounds.py -c OurMethod --validate "simulations/e2e latency comparison.csv" --validate-scale 1e-6
+
+import argparse
+import collections
+import csv
+import fnmatch
+import math
+import os
+import re
+import sys
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+PROJECT_DIR = os.path.abspath(os.path.join(SCRIPT_DIR, ".."))
+
+# Datarates of the INET Ethernet channel types used in the testbeds.
+CHANNEL_DATARATES = {
+    "Eth10M": 10e6,
+    "Eth100M": 100e6,
+    "Eth1G": 1e9,
+    "Eth10G": 10e9,
+    "Eth100G": 100e9,
+}
+
+# Protocol overheads in bytes.
+UDP_HEADER = 8
+IPV4_HEADER = 20
+IPV4_MAX_PAYLOAD = 1480            # 1500B MTU minus the IPv4 header
+ETHERNET_HEADER = 14
+IEEE8021Q_TAG = 4
+ETHERNET_FCS = 4
+ETHERNET_MIN_FRAME = 64            # header + payload + FCS
+ETHERNET_PHY_OVERHEAD = 8 + 12     # preamble + SFD, interframe gap
+PREEMPTION_MAX_BLOCKING = 143      # longest non-preemptable rest of a frame (802.3br), on the wire
+PREEMPTION_OVERHEAD = 8 + 4 + 12   # extra fragment: preamble + SMD + fragment count, mCRC, interframe gap
+
+# MacsecLayer defaults: secTagLength, icvLength and the (delay, bitrate)
+# cost model of each engine.
+MACSEC_SECTAG = 16
+MACSEC_ICV = 16
+MACSEC_ENGINES = {
+    "software": (5e-6, 1e9),
+    "hardware": (200e-9, math.inf),
+}
+
+UNITS = {
+    # time, in seconds
+    "s": 1.0, "ms": 1e-3, "us": 1e-6, "ns": 1e-9, "ps": 1e-12,
+    # data, in bits
+    "b": 1.0, "B": 8.0, "kb": 1e3, "kB": 8e3, "KiB": 8 * 1024.0, "Mb": 1e6, "MB": 8e6, "MiB": 8 * 1024.0 ** 2,
+    # datarate, in bits per second
+    "bps": 1.0, "kbps": 1e3, "Mbps": 1e6, "Gbps": 1e9,
+}
+
+
+class Ini:
+    """Minimal reader for OMNeT++ ini files with OMNeT++ lookup semantics:
+    the first matching entry wins, searching the selected configuration
+    first, then its base configurations, then [General]."""
+
+    ITERATION_VARIABLE = re.compile(r"\$\{\s*(\w+)\s*(?:=\s*([^}]*))?\}")
+
+    def __init__(self, path):
+        self.sections = collections.OrderedDict()
+        self.extends = {}
+        self._read(path, "General")
+
+    def _read(self, path, section):
+        self.sections.setdefault(section, [])
+        entry = None
+        with open(path) as f:
+            for line in f:
+                stripped = _strip_comment(line).rstrip()
+                if not stripped.strip():
+                    continue
+                if line[0].isspace() and entry is not None:
+                    # continuation of a multi-line value
+                    entry[1] += " " + stripped.strip()
+                    continue
+                stripped = stripped.strip()
+                if stripped.startswith("["):
+                    section = stripped[1:-1].strip()
+                    if section.startswith("Config "):
+                        section = section[len("Config "):].strip()
+                    self.sections.setdefault(section, [])
+                    entry = None
+                elif stripped.startswith("include "):
+                    included = os.path.join(os.path.dirname(path), stripped[len("include "):].strip())
+                    self._read(included, section)
+                    entry = None
+                else:
+                    key, _, value = stripped.partition("=")
+                    key = key.strip()
+                    if key == "extends":
+                        self.extends[section] = [base.strip() for base in value.split(",")]
+                        entry = None
+                    else:
+                        entry = [key, value.strip()]
+                        self.sections[section].append(entry)
+
+    def section_chain(self, config):
+        if config != "General" and config not in self.sections:
+            raise SystemExit(f"unknown configuration '{config}'")
+        chain = []
+
+        def visit(section):
+            if section in chain or section == "General":
+                return
+            chain.append(section)
+            for base in self.extends.get(section, []):
+                visit(base)
+
+        visit(config)
+        chain.append("General")
+        return chain
+
+    def entries(self, config, overrides=()):
+        result = [(_compile_pattern(key), value) for key, value in overrides]
+        for section in self.section_chain(config):
+            for key, value in self.sections.get(section, []):
+                result.append((_compile_pattern(key), value))
+        return result
+
+    def iteration_variables(self, config):
+        variables = collections.OrderedDict()
+        for section in self.section_chain(config):
+            for _, value in self.sections.get(section, []):
+                for name, spec in self.ITERATION_VARIABLE.findall(value):
+                    if spec:
+                        variables.setdefault(name, _iteration_values(spec))
+        return variables
+
+
+def _strip_comment(line):
+    quoted = False
+    for i, c in enumerate(line):
+        if c == '"':
+            quoted = not quoted
+        elif c == "#" and not quoted:
+            return line[:i]
+    return line
+
+
+def _iteration_values(spec):
+    spec = spec.strip()
+    match = re.fullmatch(r"([-+\d.e]+)\s*\.\.\s*([-+\d.e]+)(?:\s+step\s+([-+\d.e]+))?", spec)
+    if match:
+        start, end, step = float(match.group(1)), float(match.group(2)), float(match.group(3) or 1)
+        values = []
+        value = start
+        while value <= end + 1e-9:
+            values.append(_format_number(value))
+            value += step
+        return values
+    return [value.strip().strip('"') for value in spec.split(",")]
+
+
+def _format_number(value):
+    return str(int(value)) if float(value).is_integer() else repr(value)
+
+
+_pattern_cache = {}
+
+
+def _compile_pattern(pattern):
+    """Translates an OMNeT++ ini key pattern to a regex plus numeric ranges
+    that the captured indices must fall into."""
+    if pattern in _pattern_cache:
+        return _pattern_cache[pattern]
+    regex = ""
+    ranges = []
+    i = 0
+    while i < len(pattern):
+        c = pattern[i]
+        if pattern.startswith("**", i):
+            regex += ".*"
+            i += 2
+            continue
+        if c == "*":
+            regex += r"[^.]*"
+        elif c == "?":
+            regex += r"[^.]"
+        elif c in "[{":
+            close = pattern.index("]" if c == "[" else "}", i)
+            inner = pattern[i + 1:close]
+            numeric_range = re.fullmatch(r"(\d*)\.\.(\d*)", inner)
+            if numeric_range:
+                body = r"(\d+)"
+                ranges.append((int(numeric_range.group(1) or 0),
+                               int(numeric_range.group(2)) if numeric_range.group(2) else math.inf))
+            elif inner == "*":
+                body = r"\d+"
+            elif c == "{":
+                body = "[" + inner + "]"
+            else:
+                body = re.escape(inner)
+            regex += (r"\[" + body + r"\]") if c == "[" else body
+            i = close
+        else:
+            regex += re.escape(c)
+        i += 1
+    compiled = (re.compile(regex + r"\Z"), ranges)
+    _pattern_cache[pattern] = compiled
+    return compiled
+
+
+class Parameters:
+    """Parameter lookup for one configuration and one set of iteration
+    variable values."""
+
+    def __init__(self, ini, config, variables, overrides, network):
+        self.entries = ini.entries(config, overrides)
+        self.variables = variables
+        self.network = network
+        self.cache = {}
+
+    def raw(self, path):
+        if path not in self.cache:
+            self.cache[path] = self._lookup(path)
+        return self.cache[path]
+
+    def _lookup(self, path):
+        full_path = self.network + "." + path
+        for (regex, ranges), value in self.entries:
+            match = regex.match(full_path)
+            if match and all(lo <= int(index) <= hi for index, (lo, hi) in zip(match.groups(), ranges)):
+                return self._substitute(value)
+        return None
+
+    def _substitute(self, value):
+        def replace(match):
+            name = match.group(1)
+            if name not in self.variables:
+                raise SystemExit(f"no value for iteration variable '{name}', use --set {name}=... or --sweep {name}")
+            return self.variables[name]
+        return Ini.ITERATION_VARIABLE.sub(replace, value)
+
+    def string(self, path, default=None):
+        value = self.raw(path)
+        if value is None:
+            return default
+        value = value.strip()
+        if value.startswith("default(") and value.endswith(")"):
+            value = value[len("default("):-1]
+        return value.strip('"')
+
+    def quantity(self, path, default=None):
+        value = self.string(path)
+        if value is None:
+            return default
+        return parse_quantity(value)
+
+    def integer(self, path, default=None):
+        value = self.quantity(path)
+        return default if value is None else int(value)
+
+
+def parse_quantity(text):
+    match = re.fullmatch(r"\s*([-+]?(?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?)\s*([a-zA-Z]*)\s*", text)
+    if not match:
+        raise SystemExit(f"cannot evaluate '{text}', only constants with units are supported")
+    number, unit = float(match.group(1)), match.group(2)
+    if unit and unit not in UNITS:
+        raise SystemExit(f"unknown unit '{unit}' in '{text}'")
+    return number * UNITS[unit] if unit else number
+
+
+class Topology:
+    """Nodes and links of a testbed.ned-style network: scalar submodules
+    connected with 'a.ethg++ <--> Channel <--> b.ethg++' lines."""
+
+    def __init__(self, path, parameters_for_conditions):
+        with open(path) as f:
+            text = re.sub(r"//[^\n]*", "", f.read())
+        network = re.search(r"network\s+(\w+)", text)
+        self.name = network.group(1)
+        self.nodes = []
+        self.conditional = {}
+        submodules = text[text.index("submodules:"):text.index("connections")]
+        for match in re.finditer(r"(\w+)\s*:\s*[^{;]*?(?:\bif\s+([^{;]+))?\s*[{;]", submodules):
+            self.nodes.append(match.group(1))
+            if match.group(2):
+                self.conditional[match.group(1)] = match.group(2).strip()
+        self.node_exists = lambda node: node not in self.conditional or \
+            (parameters_for_conditions.string(f"{node}.typename", "") != "")
+        self.ports = collections.defaultdict(list)      # node -> [(neighbor, datarate)] by eth index
+        connections = text[text.index("connections"):]
+        for match in re.finditer(r"(\w+)\.ethg\+\+\s*<-->\s*([\w.]+)\s*<-->\s*(\w+)\.ethg\+\+\s*(?:if\s+exists\((\w+)\))?\s*;", connections):
+            a, channel, b, condition = match.groups()
+            if condition and not self.node_exists(condition):
+                continue
+            if not (self.node_exists(a) and self.node_exists(b)):
+                continue
+            channel = channel.split(".")[-1]
+            datarate = CHANNEL_DATARATES.get(channel)
+            if datarate is None:
+                local = re.search(r"channel\s+" + channel + r"\s+extends\s+([\w.]+)", text)
+                datarate = CHANNEL_DATARATES.get(local.group(1).split(".")[-1]) if local else None
+            if datarate is None:
+                raise SystemExit(f"unknown channel type '{channel}'")
+            self.ports[a].append((b, datarate))
+            self.ports[b].append((a, datarate))
+
+    def port_index(self, node, neighbor):
+        for index, (other, _) in enumerate(self.ports[node]):
+            if other == neighbor:
+                return index
+        raise KeyError((node, neighbor))
+
+    def shortest_path(self, source, destination):
+        previous = {source: None}
+        queue = collections.deque([source])
+        while queue:
+            node = queue.popleft()
+            if node == destination:
+                break
+            for neighbor, _ in self.ports[node]:
+                if neighbor not in previous:
+                    previous[neighbor] = node
+                    queue.append(neighbor)
+        if destination not in previous:
+            return None
+        path = [destination]
+        while previous[path[-1]] is not None:
+            path.append(previous[path[-1]])
+        return path[::-1]
+
+
+Stream = collections.namedtuple("Stream", [
+    "name", "source", "app", "destination", "sink_app", "pcp", "payload", "interval",
+    "frames", "path", "ports", "firewall_delay", "crypto_delay", "propagation_delay", "macsec_delay",
+])
+
+
+def frame_sizes(udp_payload_bytes):
+    """Wire sizes (bits, including preamble and interframe gap) of the
+    Ethernet frames carrying one UDP datagram, one per IPv4 fragment."""
+    remaining = UDP_HEADER + udp_payload_bytes
+    frames = []
+    while remaining > 0:
+        fragment = min(remaining, IPV4_MAX_PAYLOAD)
+        remaining -= fragment
+        frame = max(ETHERNET_HEADER + IEEE8021Q_TAG + IPV4_HEADER + fragment + ETHERNET_FCS, ETHERNET_MIN_FRAME)
+        frames.append(8 * (frame + ETHERNET_PHY_OVERHEAD))
+    return frames
+
+
+def stream_pcp(parameters, node, packet_name):
+    # Mirrors the stream identifier (packet name patterns) and stream encoder
+    # (stream -> PCP) mappings of the configuration; unmapped streams use PCP 0.
+    identifiers = parameters.string(f"{node}.bridging.streamIdentifier.identifier.mapping") or ""
+    encoder = parameters.string(f"{node}.bridging.streamCoder.encoder.mapping") or ""
+    pcps = dict((stream, int(pcp)) for stream, pcp in re.findall(r'stream:\s*"(\w+)"\s*,\s*pcp:\s*(\d+)', encoder))
+    for stream, pattern in re.findall(r'stream:\s*"(\w+)"\s*,\s*packetFilter:\s*expr\((?:(?!stream:).)*?name\s*=~\s*"([^"]*)"', identifiers):
+        if fnmatch.fnmatchcase(packet_name, pattern):
+            return pcps.get(stream, 0)
+    return 0
+
+
+def crypto_delay(parameters, app_path, payload_bits):
+    if parameters.string(f"{app_path}.crypto.typename", "") != "CryptoLayer":
+        return 0.0, 0
+    delay = parameters.quantity(f"{app_path}.crypto.delayer.egress.delay", 0.0)
+    bitrate = parameters.quantity(f"{app_path}.crypto.delayer.egress.bitrate", math.inf)
+    trailer = parameters.integer(f"{app_path}.crypto.cryptoAdder.trailerLength", 0)
+    trailer += parameters.integer(f"{app_path}.crypto.cryptoAdder.freshnessLength", 0)
+    return delay + payload_bits / bitrate, trailer
+
+
+def replay_check_delay(parameters, app_path):
+    if parameters.string(f"{app_path}.crypto.typename", "") != "CryptoLayer":
+        return 0.0
+    return parameters.quantity(f"{app_path}.crypto.replayCheckDelay", 0.0)
+
+
+def macsec_layer(topology, parameters, node, neighbor):
+    """Path of the MacsecLayer of node's interface towards neighbor, None
+    if the interface has no MACsec."""
+    interface = f"{node}.eth[{topology.port_index(node, neighbor)}]"
+    if parameters.string(f"{interface}.typename", "") != "MacsecEthernetInterface":
+        return None
+    if parameters.string(f"{interface}.macsecLayer.typename", "MacsecLayer") != "MacsecLayer":
+        return None
+    return f"{interface}.macsecLayer"
+
+
+def macsec_overhead(topology, parameters, port):
+    """SecTAG + ICV bytes added to every frame sent on the port."""
+    node, neighbor = port
+    layer = macsec_layer(topology, parameters, node, neighbor)
+    if layer is None:
+        return 0
+    return parameters.integer(f"{layer}.secTagLength", MACSEC_SECTAG) + parameters.integer(f"{layer}.icvLength", MACSEC_ICV)
+
+
+def macsec_engines(topology, parameters, port):
+    """(latency, bitrate) of the encryption engine at the sending end and of
+    the decryption engine at the receiving end of the port's link, None for
+    an end without MACsec."""
+    node, neighbor = port
+    engines = []
+    for layer, direction in ((macsec_layer(topology, parameters, node, neighbor), "encryption"),
+                             (macsec_layer(topology, parameters, neighbor, node), "decryption")):
+        if layer is None:
+            engines.append(None)
+            continue
+        engine_delay, engine_bitrate = MACSEC_ENGINES[parameters.string(f"{layer}.engine", "software")]
+        delay = parameters.quantity(f"{layer}.{direction}Delay", parameters.quantity(f"{layer}.encryptionDelay", engine_delay))
+        bitrate = parameters.quantity(f"{layer}.{direction}Bitrate", parameters.quantity(f"{layer}.encryptionBitrate", engine_bitrate))
+        engines.append((delay, bitrate))
+    return engines
+
+
+def engine_delay(engine, burst, rate):
+    """Delay bound of a FIFO rate-latency MACsec engine for an aggregate
+    arrival curve (burst in bits, rate in bits per second)."""
+    if engine is None:
+        return 0.0
+    latency, bitrate = engine
+    if math.isinf(bitrate):
+        return latency
+    if rate >= bitrate:
+        return math.inf
+    return latency + burst / bitrate
+
+
+def find_sink_app(parameters, node, port):
+    for index in range(parameters.integer(f"{node}.numApps", 0)):
+        if parameters.integer(f"{node}.app[{index}].io.localPort", -1) == port:
+            return index
+    return None
+
+
+def collect_streams(topology, parameters, link_delay):
+    streams = []
+    for node in topology.nodes:
+        if not topology.node_exists(node):
+            continue
+        for index in range(parameters.integer(f"{node}.numApps", 0)):
+            app = f"{node}.app[{index}]"
+            if parameters.string(f"{app}.typename", "") != "TypedUdpSourceApp":
+                continue
+            payload = int(parameters.quantity(f"{app}.source.packetLength") / 8)
+            interval = parameters.quantity(f"{app}.source.productionInterval")
+            destination = parameters.string(f"{app}.io.destAddress")
+            port = parameters.integer(f"{app}.io.destPort")
+            name_format = parameters.string(f"{app}.source.packetNameFormat", "%M-%c")
+            packet_name = name_format.replace("%M", node).replace("%c", "0")
+            pcp = stream_pcp(parameters, node, packet_name)
+
+            sink_app = find_sink_app(parameters, destination, port)
+            sender_crypto, trailer = crypto_delay(parameters, app, payload * 8)
+            receiver_crypto = 0.0
+            if sink_app is not None:
+                receiver_crypto, _ = crypto_delay(parameters, f"{destination}.app[{sink_app}]", payload * 8)
+                receiver_crypto += replay_check_delay(parameters, f"{destination}.app[{sink_app}]")
+
+            path = topology.shortest_path(node, destination)
+            if path is None:
+                raise SystemExit(f"no path from {node} to {destination}")
+            ports = [(path[i], path[i + 1]) for i in range(len(path) - 1)]
+            firewall_delay = 0.0
+            for switch in path[1:-1]:
+                if parameters.string(f"{switch}.bridging.typename", "") == "FirewallBridgingLayer":
+                    for side in ("ingress", "egress"):
+                        firewall_delay += parameters.quantity(f"{switch}.bridging.firewallProcessingDelayLayer.{side}.delay", 0.0)
+
+            streams.append(Stream(
+                name=packet_name.replace("-0", ""), source=node, app=index, destination=destination,
+                sink_app=sink_app, pcp=pcp, payload=payload, interval=interval,
+                frames=frame_sizes(payload + trailer), path=path, ports=ports,
+                firewall_delay=firewall_delay, crypto_delay=sender_crypto + receiver_crypto,
+                propagation_delay=link_delay * len(ports), macsec_delay=0.0))
+    return streams
+
+
+def port_datarate(topology, parameters, port):
+    node, neighbor = port
+    index = topology.port_index(node, neighbor)
+    configured = parameters.quantity(f"{node}.eth[{index}].bitrate")
+    return configured if configured is not None else topology.ports[node][index][1]
+
+
+def express_pcps(topology, parameters, port):
+    """PCPs sent as express frames on the port, empty without preemption."""
+    node, neighbor = port
+    if parameters.string(f"{node}.hasFramePreemption", "false") != "true":
+        return set()
+    classifier = f"{node}.eth[{topology.port_index(node, neighbor)}].macLayer.outboundClassifier"
+    if parameters.string(f"{classifier}.typename", "") != "ExpressPcpClassifier":
+        return set()
+    return set(int(pcp) for pcp in re.findall(r"\d+", parameters.string(f"{classifier}.expressPcps", "[7]")))
+
+
+def analyze(topology, parameters, streams, max_iterations=1000):
+    """Returns the per-hop queuing + transmission delay bounds of every stream,
+    and its per-hop MACsec encryption + decryption delay bounds."""
+    datarates = {}
+    express = {}
+    overheads = {}
+    engines = {}
+    flows_at_port = collections.defaultdict(list)
+    for stream_index, stream in enumerate(streams):
+        for hop, port in enumerate(stream.ports):
+            flows_at_port[port].append((stream_index, hop))
+            if port not in datarates:
+                datarates[port] = port_datarate(topology, parameters, port)
+                express[port] = express_pcps(topology, parameters, port)
+                overheads[port] = 8 * macsec_overhead(topology, parameters, port)
+                engines[port] = macsec_engines(topology, parameters, port)
+
+    rates = [sum(stream.frames) / stream.interval for stream in streams]
+    mean_frames = [sum(stream.frames) / len(stream.frames) for stream in streams]
+    initial_bursts = [float(sum(stream.frames)) for stream in streams]
+    bursts = [[initial_bursts[i]] * len(stream.ports) for i, stream in enumerate(streams)]
+    hop_delays = [[0.0] * len(stream.ports) for stream in streams]
+    macsec_delays = [[0.0] * len(stream.ports) for stream in streams]
+
+    for _ in range(max_iterations):
+        for port, flows in flows_at_port.items():
+            capacity = datarates[port]
+            # MACsec makes every frame on the port longer by the same amount.
+            growth = dict((i, 1 + overheads[port] / mean_frames[i]) for i, _ in flows)
+            # The encryption engine serves all frames of the port in order, so
+            # a frame may wait for the frames of every priority before it.
+            encryption, decryption = engines[port]
+            total_rate = sum(rates[i] for i, _ in flows)
+            encryption_delay = engine_delay(encryption, sum(bursts[i][hop] for i, hop in flows), total_rate)
+            # bursts at the queue, after the encryption engine
+            arrived = dict((i, bursts[i][hop] + rates[i] * encryption_delay) for i, hop in flows)
+            queued = dict((i, arrived[i] * growth[i]) for i, _ in flows)
+            for pcp in set(streams[i].pcp for i, _ in flows):
+                higher_burst = sum(queued[i] for i, hop in flows if streams[i].pcp > pcp)
+                higher_rate = sum(rates[i] * growth[i] for i, _ in flows if streams[i].pcp > pcp)
+                class_burst = sum(queued[i] for i, hop in flows if streams[i].pcp == pcp)
+                class_rate = sum(rates[i] * growth[i] for i, _ in flows if streams[i].pcp == pcp)
+                lower_frame = max((max(streams[i].frames) + overheads[port] for i, _ in flows if streams[i].pcp < pcp), default=0)
+                if pcp in express[port]:
+                    # Preemptable frames only block for their non-preemptable rest.
+                    lower_express = max((max(streams[i].frames) + overheads[port] for i, _ in flows
+                                         if streams[i].pcp < pcp and streams[i].pcp in express[port]), default=0)
+                    lower_frame = max(lower_express, min(lower_frame, 8 * PREEMPTION_MAX_BLOCKING))
+                elif express[port]:
+                    # Every higher express frame may split a frame of this priority.
+                    preempting = [(i, hop) for i, hop in flows if streams[i].pcp > pcp and streams[i].pcp in express[port]]
+                    higher_burst += sum(8 * PREEMPTION_OVERHEAD * arrived[i] / mean_frames[i] for i, _ in preempting)
+                    higher_rate += sum(8 * PREEMPTION_OVERHEAD * rates[i] / mean_frames[i] for i, _ in preempting)
+                service_rate = capacity - higher_rate
+                if service_rate <= class_rate:
+                    delay = math.inf
+                else:
+                    latency = (higher_burst + lower_frame) / service_rate
+                    delay = latency + class_burst / service_rate
+                for i, hop in flows:
+                    if streams[i].pcp == pcp:
+                        hop_delays[i][hop] = delay
+            # The frames reach the decryption engine as they leave the queue.
+            decryption_delay = engine_delay(
+                decryption,
+                sum(queued[i] + rates[i] * growth[i] * hop_delays[i][hop] for i, hop in flows),
+                sum(rates[i] * growth[i] for i, _ in flows))
+            for i, hop in flows:
+                macsec_delays[i][hop] = encryption_delay + decryption_delay
+
+        changed = False
+        for i, stream in enumerate(streams):
+            upstream = 0.0
+            for hop in range(len(stream.ports)):
+                burst = initial_bursts[i] + rates[i] * upstream
+                if burst != bursts[i][hop] and not (math.isinf(burst) and math.isinf(bursts[i][hop])):
+                    if math.isinf(burst) or abs(burst - bursts[i][hop]) > 1e-6 * bursts[i][hop]:
+                        changed = True
+                    bursts[i][hop] = burst
+                upstream += hop_delays[i][hop] + macsec_delays[i][hop]
+        if not changed:
+            break
+    else:
+        # no fixed point: the ring feedback makes the bounds diverge
+        diverged = [[math.inf] * len(stream.ports) for stream in streams]
+        return diverged, diverged
+    return hop_delays, macsec_delays
+
+
+def bounds_for(ini, topology_path, config, variables, overrides, link_delay):
+    network_name = re.search(r"network\s+(\w+)", open(topology_path).read()).group(1)
+    parameters = Parameters(ini, config, variables, overrides, network_name)
+    topology = Topology(topology_path, parameters)
+    streams = collect_streams(topology, parameters, link_delay)
+    hop_delays, macsec_delays = analyze(topology, parameters, streams)
+    results = []
+    for stream, delays, macsec in zip(streams, hop_delays, macsec_delays):
+        queuing = sum(delays)
+        stream = stream._replace(macsec_delay=sum(macsec))
+        total = queuing + stream.firewall_delay + stream.crypto_delay + stream.propagation_delay + stream.macsec_delay
+        results.append((stream, total, queuing))
+    return results
+
+
+def read_validation(path, scale):
+    """Reads an opp_scavetool CSV-R export (like 'e2e latency comparison.csv')
+    and returns {(config, node, app index): [(iterationvars, statistic, seconds)]}."""
+    measurements = collections.defaultdict(list)
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            match = re.fullmatch(r"[^.]+\.(\w+)\.app\[(\d+)\](?:\..*)?", row.get("module", ""))
+            if not match or not row.get("value"):
+                continue
+            key = (row.get("experiment") or row.get("configname", ""), match.group(1), int(match.group(2)))
+            measurements[key].append((row.get("iterationvars", ""), row.get("name", ""), float(row["value"]) * scale))
+    return measurements
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compute worst-case end-to-end latency bounds with network calculus.")
+    parser.add_argument("-f", "--ini", default=os.path.join(PROJECT_DIR, "simulations", "omnetpp.ini"),
+                        help="ini file (default: simulations/omnetpp.ini)")
+    parser.add_argument("-n", "--ned", default=os.path.join(PROJECT_DIR, "simulations", "testbed.ned"),
+                        help="network NED file (default: simulations/testbed.ned)")
+    parser.add_argument("-c", "--config", action="append", help="configuration to analyze; may be repeated (default: AutomaticTsn)")
+    parser.add_argument("--set", action="append", default=[], metavar="VAR=VALUE",
+                        help="value of an iteration variable, e.g. N=516")
+    parser.add_argument("--sweep", action="append", default=[], metavar="VAR",
+                        help="analyze every value of an iteration variable; may be repeated")
+    parser.add_argument("--override", action="append", default=[], metavar="PATTERN=VALUE",
+                        help="extra ini entry taking precedence over the file, e.g. '**.crypto.**.delay=50us'")
+    parser.add_argument("--link-delay", default="50ns", help="propagation delay of every link (default: 50ns, 10m cables)")
+    parser.add_argument("-o", "--output", help="write the bounds as CSV to this file")
+    parser.add_argument("--validate", metavar="CSV", help="opp_scavetool CSV export with measured e2e delays to check against the bounds")
+    parser.add_argument("--validate-scale", type=float, default=1.0,
+                        help="factor converting the values in the validation CSV to seconds (default: 1)")
+    args = parser.parse_args()
+
+    cpu_start = time.process_time()
+    ini = Ini(args.ini)
+    configs = args.config or ["AutomaticTsn"]
+    overrides = [tuple(part.strip() for part in override.split("=", 1)) for override in args.override]
+    fixed = dict(assignment.split("=", 1) for assignment in args.set)
+    link_delay = parse_quantity(args.link_delay)
+
+    rows = []
+    design_points = 0
+    for config in configs:
+        available = ini.iteration_variables(config)
+        swept = [(name, available[name]) for name in args.sweep if name in available]
+        combinations = [{}]
+        for name, values in swept:
+            combinations = [dict(combination, **{name: value}) for combination in combinations for value in values]
+        for combination in combinations:
+            variables = {name: values[0] for name, values in available.items()}
+            variables.update(fixed)
+            variables.update(combination)
+            design_points += 1
+            for stream, total, queuing in bounds_for(ini, args.ned, config, variables, overrides, link_delay):
+                rows.append((config, variables, stream, total, queuing))
+    cpu_time = time.process_time() - cpu_start
+
+    if args.output:
+        variable_names = sorted(set(name for _, variables, _, _, _ in rows for name in variables))
+        with open(args.output, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(["config"] + variable_names + ["stream", "source", "destination", "pcp", "hops",
+                                                           "bound_ms", "queuing_ms", "firewall_ms", "crypto_ms", "propagation_ms",
+                                                           "macsec_ms"])
+            for config, variables, stream, total, queuing in rows:
+                writer.writerow([config] + [variables.get(name, "") for name in variable_names] + [
+                    stream.name, stream.source, stream.destination, stream.pcp, len(stream.ports),
+                    total * 1e3, queuing * 1e3, stream.firewall_delay * 1e3, stream.crypto_delay * 1e3,
+                    stream.propagation_delay * 1e3, stream.macsec_delay * 1e3])
+    else:
+        for config, variables, stream, total, queuing in rows:
+            assignment = " ".join(f"{name}={value}" for name, value in sorted(variables.items()))
+            print(f"{config:<14} {assignment:<10} {stream.name:<32} pcp {stream.pcp}  hops {len(stream.ports)}  "
+                  f"bound {total * 1e3:9.4f} ms  (queuing {queuing * 1e3:.4f}, firewall {stream.firewall_delay * 1e3:.4f}, "
+                  f"crypto {stream.crypto_delay * 1e3:.4f}, propagation {stream.propagation_delay * 1e3:.4f}, "
+                  f"macsec {stream.macsec_delay * 1e3:.4f})")
+
+    print(f"Analyzed {design_points} design point(s), {len(rows)} stream bound(s) in {cpu_time * 1e3:.1f} ms CPU time",
+          file=sys.stderr)
+
+    if args.validate:
+        measurements = read_validation(args.validate, args.validate_scale)
+        violations = 0
+        checked = 0
+        for config, variables, stream, total, _ in rows:
+            for iterationvars, statistic, value in measurements.get((config, stream.destination, stream.sink_app), []):
+                if iterationvars and any(f"${name}={variables[name]}" not in iterationvars.replace(" ", "") for name in variables if f"${name}=" in iterationvars):
+                    continue
+                checked += 1
+                if value > total:
+                    violations += 1
+                    print(f"VIOLATION {config} {stream.name}: measured {statistic} = {value * 1e3:.4f} ms > bound {total * 1e3:.4f} ms")
+        print(f"Validated {checked} measurement(s) against the bounds, {violations} violation(s)", file=sys.stderr)
+        return 1 if violations else 0
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
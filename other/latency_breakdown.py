@@ -0,0 +1,111 @@
+# Tabulates the per-stage end-to-end delay decomposition of every stream.
+#
+# Reads an opp_scavetool CSV-R export of the StageTimingRecorder statistics
+# of the StageTiming* configurations, e.g.
+#   opp_scavetool export -f 'module =~ **.measurementRecorder' -F CSV-R -o breakdown.csv results/StageTiming*.sca
+# CSV-R has no configuration column on the result rows, so the configuration
+# of a result is looked up by its run ID in the 'configname' run attribute
+# rows that the export writes for every run, and its iteration variables
+# (e.g. "$N=516") in the 'iterationvars' rows. The script prints, per
+# configuration, iteration and sink, where the mean (or maximum) end-to-end
+# delay is spent: crypto, firewall, queueing, transmission and other time.
+# Repetitions of an iteration are averaged for the mean and combined with
+# max() for the maximum. With two configurations (-c A -c B) it also prints
+# the difference B - A per stage and iteration, e.g. to see what makes up
+# the gap between ChaChaPoly and OurMethod.
+#
+# Usage (from the project root):
+#   python3 other/latency_breakdown.py breakdown.csv
+#   python3 other/latency_breakdown.py breakdown.csv -c StageTimingOurMethod -c StageTimingChaChaPoly --statistic max
+#   python3 other/latency_breakdown.py breakdown.csv -c StageTimingOurMethod -i '$N=516'
+
+import argparse
+import collections
+import csv
+import re
+import sys
+
+STAGES = ["cryptoTime", "firewallTime", "queueingTime", "transmissionTime", "otherTime"]
+TOTAL = "stagedEndToEndDelay"
+
+
+def read_breakdown(path, statistic):
+    """Returns {config: {iterationvars: {sink: {stage: [values over repetitions]}}}}."""
+    breakdown = collections.defaultdict(lambda: collections.defaultdict(
+        lambda: collections.defaultdict(lambda: collections.defaultdict(list))))
+    with open(path, newline="") as f:
+        rows = list(csv.DictReader(f))
+    run_attributes = collections.defaultdict(dict)
+    for row in rows:
+        if row.get("type") == "runattr":
+            run_attributes[row.get("run")][row.get("attrname")] = row.get("attrvalue", "")
+    for row in rows:
+        name, _, recorded = row.get("name", "").partition(":")
+        if name not in STAGES + [TOTAL] or recorded != statistic or not row.get("value"):
+            continue
+        match = re.fullmatch(r"[^.]+\.(\w+\.app\[\d+\])\..*", row.get("module", ""))
+        sink = match.group(1) if match else row.get("module", "")
+        attributes = run_attributes[row.get("run")]
+        config = row.get("experiment") or row.get("configname") or attributes.get("configname", "")
+        iteration = row.get("iterationvars") or attributes.get("iterationvars", "")
+        breakdown[config][iteration][sink][name].append(float(row["value"]))
+    return breakdown
+
+
+def iteration_key(iteration):
+    """Sorts "$N=4" before "$N=132"."""
+    return [int(part) if part.isdigit() else part for part in re.split(r"(\d+)", iteration)]
+
+
+def mean(values):
+    return sum(values) / len(values) if values else 0.0
+
+
+def print_table(title, rows):
+    print(title)
+    print(f"  {'sink':<24}" + "".join(f"{stage[:-4]:>14}" for stage in STAGES) + f"{'total':>14}")
+    for sink, values in rows:
+        print(f"  {sink:<24}" + "".join(f"{values[stage] * 1e6:11.3f} us" for stage in STAGES + [TOTAL]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Tabulate the per-stage end-to-end delay decomposition.")
+    parser.add_argument("csv", help="opp_scavetool CSV-R export of the StageTimingRecorder statistics")
+    parser.add_argument("-c", "--config", action="append", help="configuration to show; may be repeated (default: all)")
+    parser.add_argument("-i", "--iteration", action="append",
+                        help="iteration variables to show, e.g. '$N=516'; may be repeated (default: all)")
+    parser.add_argument("--statistic", default="mean", choices=["mean", "max"], help="recorded statistic (default: mean)")
+    args = parser.parse_args()
+
+    breakdown = read_breakdown(args.csv, args.statistic)
+    combine = max if args.statistic == "max" else mean
+    configs = args.config or sorted(breakdown)
+    combined = {}
+    for config in configs:
+        if config not in breakdown:
+            print(f"no {args.statistic} stage statistics for {config} in {args.csv}", file=sys.stderr)
+            return 1
+        iterations = args.iteration or sorted(breakdown[config], key=iteration_key)
+        for iteration in iterations:
+            if iteration not in breakdown[config]:
+                print(f"no {args.statistic} stage statistics for {config} {iteration} in {args.csv}", file=sys.stderr)
+                return 1
+            combined[config, iteration] = {sink: {stage: combine(stages[stage]) if stages[stage] else 0.0
+                                                  for stage in STAGES + [TOTAL]}
+                                           for sink, stages in sorted(breakdown[config][iteration].items())}
+            print_table(f"{config} {iteration}".strip() + f" ({args.statistic}):", combined[config, iteration].items())
+
+    if len(configs) == 2:
+        iterations = [iteration for config, iteration in combined if config == configs[0]]
+        for iteration in iterations:
+            if (configs[1], iteration) not in combined:
+                continue
+            first, second = combined[configs[0], iteration], combined[configs[1], iteration]
+            rows = [(sink, {stage: second[sink][stage] - first[sink][stage] for stage in STAGES + [TOTAL]})
+                    for sink in first if sink in second]
+            print_table(f"{configs[1]} - {configs[0]} {iteration}".strip() + ":", rows)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,156 @@
+# Reports the CDT latency improvement of frame preemption per security method.
+#
+# Compares every method (AutomaticTsn, OurMethod, SipHash, ChaChaPoly) with
+# its Preemption* variant, in which control data traffic (CDT) preempts
+# lower priority frames on the zonal gateway egress ports:
+#
+#  - analytically, with the worst-case bounds of latency_bounds.py
+#  - optionally from simulation results, given as an opp_scavetool CSV export
+#    of the sinks' end-to-end delay statistics (like 'e2e latency
+#    comparison.csv'), e.g.
+#      opp_scavetool export -f 'module =~ **.sink' -F CSV-R -o preemption.csv results/*.sca results/*.vec
+#
+# For each method it prints the worst (bound) or average (measured) CDT
+# latency without and with preemption, and the ranking of the methods in
+# both cases, to show whether preemption changes their order.
+#
+# Usage (from the project root):
+#   python3 other/preemption_report.py
+#   python3 other/preemption_report.py --sweep N -o preemption.csv
+#   python3 other/preemption_report.py --results preemption.csv --results-scale 1
+
+import argparse
+import collections
+import csv
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import latency_bounds  # noqa: E402
+
+METHODS = ["AutomaticTsn", "OurMethod", "SipHash", "ChaChaPoly"]
+PREEMPTION_PREFIX = "Preemption"
+
+
+def design_points(ini, config, fixed, sweep):
+    available = ini.iteration_variables(config)
+    combinations = [{}]
+    for name in sweep:
+        if name in available:
+            combinations = [dict(combination, **{name: value}) for combination in combinations for value in available[name]]
+    for combination in combinations:
+        variables = {name: values[0] for name, values in available.items()}
+        variables.update(fixed)
+        variables.update(combination)
+        yield variables
+
+
+def cdt_bounds(args, ini, config, variables, link_delay):
+    results = latency_bounds.bounds_for(ini, args.ned, config, variables, [], link_delay)
+    return [(stream, total) for stream, total, _ in results if stream.name.endswith(":" + args.stream_class)]
+
+
+def print_ranking(title, values):
+    # values: {method: (without, with)}
+    for index, label in ((0, "without preemption"), (1, "with preemption")):
+        order = sorted(values, key=lambda method: values[method][index])
+        print(f"  {title} ranking {label:<19} " + " < ".join(order))
+    before = sorted(values, key=lambda method: values[method][0])
+    after = sorted(values, key=lambda method: values[method][1])
+    print(f"  ranking {'changed' if before != after else 'unchanged'}")
+
+
+def report_bounds(args, ini, link_delay, writer):
+    fixed = dict(assignment.split("=", 1) for assignment in args.set)
+    for variables in design_points(ini, args.methods[0], fixed, args.sweep):
+        assignment = " ".join(f"{name}={value}" for name, value in sorted(variables.items()))
+        print(f"Worst-case {args.stream_class} bounds, {assignment}:")
+        worst = {}
+        for method in args.methods:
+            without = cdt_bounds(args, ini, method, variables, link_delay)
+            with_preemption = dict((stream.name, total) for stream, total in
+                                   cdt_bounds(args, ini, PREEMPTION_PREFIX + method, variables, link_delay))
+            for stream, total in without:
+                preempted = with_preemption.get(stream.name, total)
+                if args.verbose:
+                    print(f"    {method:<14} {stream.name:<32} {total * 1e3:9.4f} ms -> {preempted * 1e3:9.4f} ms")
+                if writer is not None:
+                    writer.writerow(["bound", method, assignment, stream.name, total * 1e3, preempted * 1e3])
+            worst[method] = (max(total for _, total in without), max(with_preemption.values()))
+            before, after = worst[method]
+            best_gain = max(total - with_preemption.get(stream.name, total) for stream, total in without)
+            print(f"  {method:<14} worst {before * 1e3:9.4f} ms -> {after * 1e3:9.4f} ms  "
+                  f"({(before - after) * 1e3:+.4f} ms, {(before - after) / before:+.1%}), "
+                  f"largest gain of a stream {best_gain * 1e3:.4f} ms")
+        print_ranking("bound", worst)
+
+
+def report_results(args, ini, link_delay, writer):
+    measurements = latency_bounds.read_validation(args.results, args.results_scale)
+    fixed = dict(assignment.split("=", 1) for assignment in args.set)
+    variables = next(design_points(ini, args.methods[0], fixed, []))
+    print(f"Measured {args.stream_class} latency (average over sinks and runs):")
+    averages = {}
+    for method in args.methods:
+        sinks = set((stream.destination, stream.sink_app) for stream, _ in cdt_bounds(args, ini, method, variables, link_delay))
+        values = collections.defaultdict(lambda: ([], []))
+        for index, config in enumerate((method, PREEMPTION_PREFIX + method)):
+            for node, app in sinks:
+                for _, statistic, value in measurements.get((config, node, app), []):
+                    if args.statistic in statistic:
+                        values[statistic][index].append(value)
+        for statistic, (without, with_preemption) in sorted(values.items()):
+            if not without or not with_preemption:
+                continue
+            before = sum(without) / len(without)
+            after = sum(with_preemption) / len(with_preemption)
+            averages.setdefault(method, (before, after))
+            print(f"  {method:<14} {statistic:<40} {before * 1e3:9.4f} ms -> {after * 1e3:9.4f} ms  "
+                  f"({(before - after) * 1e3:+.4f} ms, {(before - after) / before:+.1%})")
+            if writer is not None:
+                writer.writerow(["measured", method, "", statistic, before * 1e3, after * 1e3])
+    if len(averages) > 1:
+        print_ranking("measured", averages)
+    elif not averages:
+        print(f"  no results for {', '.join(args.methods)} and their {PREEMPTION_PREFIX}* variants in {args.results}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report the CDT latency improvement of frame preemption per method.")
+    parser.add_argument("-f", "--ini", default=os.path.join(latency_bounds.PROJECT_DIR, "simulations", "omnetpp.ini"),
+                        help="ini file (default: simulations/omnetpp.ini)")
+    parser.add_argument("-n", "--ned", default=os.path.join(latency_bounds.PROJECT_DIR, "simulations", "testbed.ned"),
+                        help="network NED file (default: simulations/testbed.ned)")
+    parser.add_argument("-m", "--method", dest="methods", action="append",
+                        help=f"method configuration; may be repeated (default: {', '.join(METHODS)})")
+    parser.add_argument("--stream-class", default="CDT", help="stream class to report (default: CDT)")
+    parser.add_argument("--set", action="append", default=[], metavar="VAR=VALUE",
+                        help="value of an iteration variable, e.g. N=516")
+    parser.add_argument("--sweep", action="append", default=[], metavar="VAR",
+                        help="report every value of an iteration variable; may be repeated")
+    parser.add_argument("--link-delay", default="50ns", help="propagation delay of every link (default: 50ns)")
+    parser.add_argument("--results", metavar="CSV", help="opp_scavetool CSV-R export with the measured sink statistics")
+    parser.add_argument("--results-scale", type=float, default=1.0,
+                        help="factor converting the values in the results CSV to seconds (default: 1)")
+    parser.add_argument("--statistic", default="", help="only report measured statistics containing this text")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print the bounds of every stream")
+    parser.add_argument("-o", "--output", help="also write the per-stream values as CSV to this file")
+    args = parser.parse_args()
+    args.methods = args.methods or METHODS
+
+    ini = latency_bounds.Ini(args.ini)
+    link_delay = latency_bounds.parse_quantity(args.link_delay)
+    output = open(args.output, "w", newline="") if args.output else None
+    writer = csv.writer(output) if output is not None else None
+    if writer is not None:
+        writer.writerow(["kind", "method", "variables", "stream_or_statistic", "without_ms", "with_preemption_ms"])
+    report_bounds(args, ini, link_delay, writer)
+    if args.results:
+        report_results(args, ini, link_delay, writer)
+    if output is not None:
+        output.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
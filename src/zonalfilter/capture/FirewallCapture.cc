@@ -0,0 +1,183 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/capture/FirewallCapture.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+#include "inet/common/ProtocolGroup.h"
+#include "inet/common/ProtocolTag_m.h"
+#include "inet/common/TimeTag_m.h"
+#include "inet/common/packet/chunk/BytesChunk.h"
+#include "inet/linklayer/common/MacAddressTag_m.h"
+#include "inet/linklayer/common/PcpTag_m.h"
+#include "inet/linklayer/common/VlanTag_m.h"
+#include "zonalfilter/crypto/CryptoTimeTag_m.h"
+
+Define_Module(FirewallCapture);
+
+namespace {
+
+const uint16_t LINKTYPE_ETHERNET = 1;
+const uint16_t ETHERTYPE_VLAN = 0x8100;
+const uint16_t ETHERTYPE_LOCAL_EXPERIMENTAL = 0x88b5;
+const uint32_t EPB_FLAGS_INBOUND = 1;
+const uint32_t EPB_FLAGS_OUTBOUND = 2;
+
+inline void put16(uint8_t *p, uint16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value & 0xff;
+}
+
+} // namespace
+
+void FirewallCapture::initialize(int stage)
+{
+    if (stage == INITSTAGE_LOCAL) {
+        std::string application = std::string("zonalfilter ") + getParentModule()->getFullPath();
+        writer.reset(new PcapngWriter(par("fileName").stringValue(), par("bufferSize").intValue(), par("numBuffers").intValue(), application.c_str()));
+        interfaceMatcher.setPattern(par("interfaces").stringValue(), false, true, true);
+        snapLength = B(par("snapLength").intValue());
+        captureUntyped = par("captureUntyped").boolValue();
+        privateEnterpriseNumber = par("privateEnterpriseNumber").intValue();
+    }
+}
+
+void FirewallCapture::handleMessage(cMessage *message)
+{
+    throw cRuntimeError("This module does not process messages");
+}
+
+int FirewallCapture::getInterfaceId(const char *interfaceName)
+{
+    auto it = interfaceIds.find(interfaceName);
+    if (it != interfaceIds.end())
+        return it->second;
+    // Interfaces are added when first seen, so the file only lists ports
+    // that carried traffic.
+    int interfaceId = -1;
+    if (interfaceMatcher.matches(interfaceName))
+        interfaceId = writer->addInterface(*interfaceName != '\0' ? interfaceName : "unknown", LINKTYPE_ETHERNET, snapLength.get());
+    interfaceIds[interfaceName] = interfaceId;
+    return interfaceId;
+}
+
+uint32_t FirewallCapture::createFrameHeader(const Packet *packet, bool isIngress, uint8_t *header) const
+{
+    auto protocolTag = packet->findTag<PacketProtocolTag>();
+    const Protocol *protocol = protocolTag != nullptr ? protocolTag->getProtocol() : nullptr;
+    if (protocol == &Protocol::ethernetMac)
+        return 0; // the packet is a complete frame already
+
+    MacAddress source, destination;
+    auto macAddressInd = packet->findTag<MacAddressInd>();
+    auto macAddressReq = packet->findTag<MacAddressReq>();
+    if (macAddressReq != nullptr && (!isIngress || macAddressInd == nullptr)) {
+        source = macAddressReq->getSrcAddress();
+        destination = macAddressReq->getDestAddress();
+    }
+    else if (macAddressInd != nullptr) {
+        source = macAddressInd->getSrcAddress();
+        destination = macAddressInd->getDestAddress();
+    }
+    destination.getAddressBytes(header);
+    source.getAddressBytes(header + 6);
+    uint32_t length = 12;
+
+    auto vlanInd = packet->findTag<VlanInd>();
+    auto vlanReq = packet->findTag<VlanReq>();
+    auto pcpInd = packet->findTag<PcpInd>();
+    auto pcpReq = packet->findTag<PcpReq>();
+    int vlanId = vlanReq != nullptr && (!isIngress || vlanInd == nullptr) ? vlanReq->getVlanId() : vlanInd != nullptr ? vlanInd->getVlanId() : -1;
+    int pcp = pcpReq != nullptr && (!isIngress || pcpInd == nullptr) ? pcpReq->getPcp() : pcpInd != nullptr ? pcpInd->getPcp() : -1;
+    if (vlanId != -1 || pcp != -1) {
+        put16(header + length, ETHERTYPE_VLAN);
+        put16(header + length + 2, (std::max(pcp, 0) << 13) | (std::max(vlanId, 0) & 0xfff));
+        length += 4;
+    }
+
+    int etherType = protocol != nullptr ? ProtocolGroup::getEthertypeProtocolGroup()->findProtocolNumber(protocol) : -1;
+    put16(header + length, etherType != -1 ? etherType : ETHERTYPE_LOCAL_EXPERIMENTAL);
+    return length + 2;
+}
+
+void FirewallCapture::captureDecision(const Packet *packet, const char *interfaceName, const char *type, bool isIngress, bool accepted)
+{
+    Enter_Method_Silent();
+    if (type == nullptr && !captureUntyped)
+        return;
+    int interfaceId = getInterfaceId(interfaceName);
+    if (interfaceId == -1)
+        return;
+
+    uint8_t header[18];
+    uint32_t headerLength = createFrameHeader(packet, isIngress, header);
+    B dataLength = packet->getDataLength();
+    B capturedLength = std::min(dataLength, std::max(snapLength - B(headerLength), B(0)));
+    Ptr<const BytesChunk> data;
+    if (capturedLength > B(0)) {
+        try {
+            data = packet->peekDataAt<BytesChunk>(b(0), capturedLength);
+        }
+        catch (cRuntimeError& e) {
+            // Chunks without a serializer can still be captured as metadata.
+            capturedLength = B(0);
+        }
+    }
+
+    char createdTime[32] = "-";
+    auto creationTimeTags = packet->getAllRegionTags<CreationTimeTag>();
+    if (!creationTimeTags.empty())
+        snprintf(createdTime, sizeof(createdTime), "%" PRId64 "ns", creationTimeTags[0].getTag()->getCreationTime().inUnit(SIMTIME_NS));
+    char cryptoTime[32] = "-";
+    auto cryptoTimeTags = packet->getAllRegionTags<CryptoTimeTag>();
+    if (!cryptoTimeTags.empty())
+        snprintf(cryptoTime, sizeof(cryptoTime), "%" PRId64 "ns", cryptoTimeTags[0].getTag()->getProtectionTime().inUnit(SIMTIME_NS));
+    int64_t firewallTime = simTime().inUnit(SIMTIME_NS);
+    const char *filter = isIngress ? "ingress" : "egress";
+    const char *decision = accepted ? "accept" : "drop";
+    const char *typeName = type != nullptr ? type : "-";
+
+    char custom[512];
+    snprintf(custom, sizeof(custom), "filter=%s;interface=%s;type=%s;decision=%s;created=%s;crypto=%s;firewall=%" PRId64 "ns",
+            filter, interfaceName, typeName, decision, createdTime, cryptoTime, firewallTime);
+    char comment[512];
+    snprintf(comment, sizeof(comment), "%s %s %s: %s (created %s, crypto %s)",
+            filter, interfaceName, typeName, accepted ? "accepted" : "DROPPED", createdTime, cryptoTime);
+
+    PcapngWriter::EnhancedPacket block;
+    block.interfaceId = interfaceId;
+    block.timestamp = firewallTime;
+    block.header = header;
+    block.headerLength = headerLength;
+    block.data = capturedLength > B(0) ? data->getBytes().data() : nullptr;
+    block.dataLength = capturedLength.get();
+    block.originalLength = headerLength + dataLength.get();
+    block.flags = isIngress ? EPB_FLAGS_INBOUND : EPB_FLAGS_OUTBOUND;
+    block.comment = comment;
+    block.privateEnterpriseNumber = privateEnterpriseNumber;
+    block.custom = custom;
+    writer->writePacket(block);
+}
+
+void FirewallCapture::finish()
+{
+    writer->close();
+    EV_INFO << "Captured " << writer->getNumPackets() << " packets (" << writer->getNumBytes() << " bytes) to " << par("fileName").stringValue()
+            << ", waited " << writer->getStallTime() << " s for the writer thread" << EV_ENDL;
+}
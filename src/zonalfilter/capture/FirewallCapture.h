@@ -0,0 +1,64 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_FIREWALLCAPTURE_H_
+#define __ZONALFILTER_FIREWALLCAPTURE_H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "inet/common/INETDefs.h"
+#include "inet/common/packet/Packet.h"
+#include "zonalfilter/capture/PcapngWriter.h"
+
+using namespace inet;
+
+/**
+ * Captures the packets seen by the firewall filters of a zonal gateway into
+ * a pcapng file, with one interface per gateway port. Every packet block is
+ * annotated with the filter (ingress/egress, also as epb_flags direction),
+ * the message type, the firewall decision, and the creation and crypto
+ * timestamps of the packet, both as a packet comment and as a custom
+ * option. The filters call captureDecision() for every decision.
+ *
+ * The frames are reconstructed from the packet's address, VLAN and protocol
+ * tags, because the Ethernet header is not part of the packet in the
+ * bridging layer; at most snapLength bytes are serialized.
+ */
+class FirewallCapture : public cSimpleModule
+{
+  protected:
+    std::unique_ptr<PcapngWriter> writer;
+    cPatternMatcher interfaceMatcher;
+    B snapLength = B(0);
+    bool captureUntyped = false;
+    uint32_t privateEnterpriseNumber = 0;
+    std::map<std::string, int> interfaceIds; // -1 for interfaces not captured
+
+  protected:
+    virtual int numInitStages() const override { return NUM_INIT_STAGES; }
+    virtual void initialize(int stage) override;
+    virtual void handleMessage(cMessage *message) override;
+    virtual void finish() override;
+
+    int getInterfaceId(const char *interfaceName);
+    uint32_t createFrameHeader(const Packet *packet, bool isIngress, uint8_t *header) const;
+
+  public:
+    void captureDecision(const Packet *packet, const char *interfaceName, const char *type, bool isIngress, bool accepted);
+};
+
+#endif
@@ -0,0 +1,271 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/capture/PcapngWriter.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+namespace {
+
+const uint32_t SECTION_HEADER_BLOCK = 0x0a0d0d0a;
+const uint32_t INTERFACE_DESCRIPTION_BLOCK = 1;
+const uint32_t ENHANCED_PACKET_BLOCK = 6;
+const uint32_t BYTE_ORDER_MAGIC = 0x1a2b3c4d;
+
+const uint16_t OPTION_END = 0;
+const uint16_t OPTION_COMMENT = 1;
+const uint16_t OPTION_CUSTOM_STRING = 2988; // copyable
+const uint16_t SHB_USERAPPL = 4;
+const uint16_t IF_NAME = 2;
+const uint16_t IF_TSRESOL = 9;
+const uint16_t EPB_FLAGS = 2;
+
+inline size_t pad4(size_t length) { return (length + 3) & ~size_t(3); }
+
+inline size_t optionLength(size_t valueLength) { return 4 + pad4(valueLength); }
+
+inline void put16(uint8_t *& p, uint16_t value) { memcpy(p, &value, 2); p += 2; }
+
+inline void put32(uint8_t *& p, uint32_t value) { memcpy(p, &value, 4); p += 4; }
+
+inline void putPadded(uint8_t *& p, const void *data, size_t length)
+{
+    memcpy(p, data, length);
+    memset(p + length, 0, pad4(length) - length);
+    p += pad4(length);
+}
+
+inline void putOption(uint8_t *& p, uint16_t code, const void *value, size_t length)
+{
+    put16(p, code);
+    put16(p, length);
+    putPadded(p, value, length);
+}
+
+void makeParentDirectories(const std::string& fileName)
+{
+    for (size_t slash = fileName.find('/', 1); slash != std::string::npos; slash = fileName.find('/', slash + 1))
+        mkdir(fileName.substr(0, slash).c_str(), 0755); // existing directories are fine
+}
+
+} // namespace
+
+PcapngWriter::PcapngWriter(const char *fileName, size_t bufferSize, int numBuffers, const char *application) :
+    fileName(fileName), buffers(std::max(numBuffers, 2))
+{
+    for (auto& buffer : buffers) {
+        buffer.data.resize(bufferSize);
+        freeBuffers.push_back(&buffer);
+    }
+    active = freeBuffers.back();
+    freeBuffers.pop_back();
+
+    // The section header goes to the empty active buffer, so reserve() can
+    // only throw here (block too large) and never needs the writer thread.
+    size_t applicationLength = strlen(application);
+    size_t blockLength = 28 + optionLength(applicationLength) + 4;
+    uint8_t *p = reserve(blockLength);
+    put32(p, SECTION_HEADER_BLOCK);
+    put32(p, blockLength);
+    put32(p, BYTE_ORDER_MAGIC);
+    put16(p, 1); // version 1.0
+    put16(p, 0);
+    int64_t sectionLength = -1; // unknown, the file is written sequentially
+    memcpy(p, &sectionLength, 8);
+    p += 8;
+    putOption(p, SHB_USERAPPL, application, applicationLength);
+    putOption(p, OPTION_END, nullptr, 0);
+    put32(p, blockLength);
+
+    // Start the thread last: nothing may throw after it, because the
+    // destructor of a partially constructed writer does not run to join it.
+    makeParentDirectories(fileName);
+    fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw cRuntimeError("Cannot create capture file '%s': %s", fileName, strerror(errno));
+    writerThread = std::thread(&PcapngWriter::writerLoop, this);
+}
+
+PcapngWriter::~PcapngWriter()
+{
+    try {
+        close();
+    }
+    catch (std::exception& e) {
+        // errors are reported by an explicit close()
+    }
+}
+
+uint32_t PcapngWriter::addInterface(const char *name, uint16_t linkType, uint32_t snapLength)
+{
+    size_t nameLength = strlen(name);
+    size_t blockLength = 16 + optionLength(nameLength) + optionLength(1) + 4 + 4;
+    uint8_t *p = reserve(blockLength);
+    put32(p, INTERFACE_DESCRIPTION_BLOCK);
+    put32(p, blockLength);
+    put16(p, linkType);
+    put16(p, 0);
+    put32(p, snapLength);
+    putOption(p, IF_NAME, name, nameLength);
+    uint8_t resolution = 9; // 10^-9 s
+    putOption(p, IF_TSRESOL, &resolution, 1);
+    putOption(p, OPTION_END, nullptr, 0);
+    put32(p, blockLength);
+    return numInterfaces++;
+}
+
+void PcapngWriter::writePacket(const EnhancedPacket& packet)
+{
+    uint32_t capturedLength = packet.headerLength + packet.dataLength;
+    size_t commentLength = packet.comment != nullptr ? strlen(packet.comment) : 0;
+    size_t customLength = packet.custom != nullptr ? strlen(packet.custom) : 0;
+    size_t optionsLength = 0;
+    if (commentLength != 0)
+        optionsLength += optionLength(commentLength);
+    if (packet.flags != 0)
+        optionsLength += optionLength(4);
+    if (customLength != 0)
+        optionsLength += optionLength(4 + customLength);
+    if (optionsLength != 0)
+        optionsLength += 4;
+    size_t blockLength = 28 + pad4(capturedLength) + optionsLength + 4;
+
+    uint8_t *p = reserve(blockLength);
+    put32(p, ENHANCED_PACKET_BLOCK);
+    put32(p, blockLength);
+    put32(p, packet.interfaceId);
+    put32(p, (uint64_t)packet.timestamp >> 32);
+    put32(p, (uint32_t)packet.timestamp);
+    put32(p, capturedLength);
+    put32(p, packet.originalLength);
+    if (packet.headerLength != 0)
+        memcpy(p, packet.header, packet.headerLength);
+    if (packet.dataLength != 0)
+        memcpy(p + packet.headerLength, packet.data, packet.dataLength);
+    memset(p + capturedLength, 0, pad4(capturedLength) - capturedLength);
+    p += pad4(capturedLength);
+    if (commentLength != 0)
+        putOption(p, OPTION_COMMENT, packet.comment, commentLength);
+    if (packet.flags != 0)
+        putOption(p, EPB_FLAGS, &packet.flags, 4);
+    if (customLength != 0) {
+        put16(p, OPTION_CUSTOM_STRING);
+        put16(p, 4 + customLength);
+        uint8_t *value = p;
+        put32(p, packet.privateEnterpriseNumber);
+        memcpy(p, packet.custom, customLength);
+        p = value + pad4(4 + customLength);
+        memset(value + 4 + customLength, 0, pad4(4 + customLength) - 4 - customLength);
+    }
+    if (optionsLength != 0)
+        putOption(p, OPTION_END, nullptr, 0);
+    put32(p, blockLength);
+
+    numPackets++;
+    numBytes += blockLength;
+}
+
+uint8_t *PcapngWriter::reserve(size_t length)
+{
+    if (length > active->data.size())
+        throw cRuntimeError("Capture block of %zu bytes does not fit the %zu bytes capture buffer", length, active->data.size());
+    if (active->used + length > active->data.size())
+        submitActiveBuffer();
+    uint8_t *p = active->data.data() + active->used;
+    active->used += length;
+    return p;
+}
+
+void PcapngWriter::submitActiveBuffer()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    checkWriteError();
+    fullBuffers.push_back(active);
+    active = nullptr;
+    condition.notify_all();
+    if (freeBuffers.empty()) {
+        auto start = std::chrono::steady_clock::now();
+        condition.wait(lock, [this] () { return !freeBuffers.empty(); });
+        stallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    active = freeBuffers.back();
+    freeBuffers.pop_back();
+    active->used = 0;
+}
+
+void PcapngWriter::checkWriteError()
+{
+    if (writeError != 0)
+        throw cRuntimeError("Cannot write capture file '%s': %s", fileName.c_str(), strerror(writeError));
+}
+
+void PcapngWriter::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        condition.wait(lock, [this] () { return !fullBuffers.empty() || stopping; });
+        if (fullBuffers.empty())
+            break;
+        Buffer *buffer = fullBuffers.front();
+        fullBuffers.pop_front();
+        lock.unlock();
+        int error = 0;
+        for (size_t offset = 0; offset < buffer->used;) {
+            ssize_t written = ::write(fd, buffer->data.data() + offset, buffer->used - offset);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                error = errno;
+                break;
+            }
+            offset += written;
+        }
+        lock.lock();
+        if (error != 0 && writeError == 0)
+            writeError = error;
+        freeBuffers.push_back(buffer);
+        condition.notify_all();
+    }
+}
+
+void PcapngWriter::close()
+{
+    if (fd < 0)
+        return;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (active != nullptr && active->used != 0)
+            fullBuffers.push_back(active);
+        active = nullptr;
+        stopping = true;
+        condition.notify_all();
+    }
+    writerThread.join();
+    int error = ::close(fd) < 0 ? errno : 0;
+    fd = -1;
+    checkWriteError();
+    if (error != 0)
+        throw cRuntimeError("Cannot close capture file '%s': %s", fileName.c_str(), strerror(error));
+}
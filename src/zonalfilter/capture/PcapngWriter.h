@@ -0,0 +1,114 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_PCAPNGWRITER_H_
+#define __ZONALFILTER_PCAPNGWRITER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Writes a pcapng file from a background thread.
+ *
+ * Blocks are formatted into large in-memory buffers on the caller's thread;
+ * full buffers are handed to a writer thread that does the (blocking) file
+ * I/O, so capturing costs the simulation little more than a memcpy. The
+ * caller only waits if all buffers are queued for writing, i.e. if the disk
+ * cannot keep up; that time is reported by getStallTime().
+ *
+ * Timestamps are written with nanosecond resolution.
+ */
+class PcapngWriter
+{
+  public:
+    struct EnhancedPacket {
+        uint32_t interfaceId = 0;
+        int64_t timestamp = 0; // ns
+        const uint8_t *header = nullptr; // written in front of data, may be null
+        uint32_t headerLength = 0;
+        const uint8_t *data = nullptr;
+        uint32_t dataLength = 0; // captured bytes of data
+        uint32_t originalLength = 0; // of header and data together
+        uint32_t flags = 0; // epb_flags, 0 means none
+        const char *comment = nullptr; // opt_comment
+        uint32_t privateEnterpriseNumber = 0;
+        const char *custom = nullptr; // custom string option (copyable) with the enterprise number
+    };
+
+  protected:
+    struct Buffer {
+        std::vector<uint8_t> data;
+        size_t used = 0;
+    };
+
+    std::string fileName;
+    int fd = -1;
+    std::vector<Buffer> buffers;
+    Buffer *active = nullptr;
+    uint32_t numInterfaces = 0;
+
+    std::thread writerThread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Buffer *> fullBuffers;
+    std::vector<Buffer *> freeBuffers;
+    bool stopping = false;
+    int writeError = 0;
+
+    uint64_t numPackets = 0;
+    uint64_t numBytes = 0;
+    double stallTime = 0; // s
+
+  protected:
+    void writerLoop();
+    void submitActiveBuffer();
+    uint8_t *reserve(size_t length);
+    void checkWriteError();
+
+  public:
+    /**
+     * Creates the file and writes the section header. bufferSize bounds the
+     * size of a single block.
+     */
+    PcapngWriter(const char *fileName, size_t bufferSize, int numBuffers, const char *application);
+    ~PcapngWriter();
+
+    PcapngWriter(const PcapngWriter&) = delete;
+    PcapngWriter& operator=(const PcapngWriter&) = delete;
+
+    /**
+     * Writes an interface description block and returns its interface ID.
+     */
+    uint32_t addInterface(const char *name, uint16_t linkType, uint32_t snapLength);
+
+    void writePacket(const EnhancedPacket& packet);
+
+    /**
+     * Writes all buffered blocks, waits for the writer thread and closes the
+     * file. Called by the destructor if not called before.
+     */
+    void close();
+
+    uint64_t getNumPackets() const { return numPackets; }
+    uint64_t getNumBytes() const { return numBytes; }
+    double getStallTime() const { return stallTime; }
+};
+
+#endif
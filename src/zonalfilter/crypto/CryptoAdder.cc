@@ -14,11 +14,38 @@
 // 
 
 #include "CryptoAdder.h"
-#include "inet/common/packet/chunk/ByteCountChunk.h"
+#include "zonalfilter/crypto/CryptoTimeTag_m.h"
+#include "zonalfilter/crypto/FreshnessTag_m.h"
+#include "zonalfilter/timing/StageTiming.h"
 
 Define_Module(CryptoAdder);
 
+void CryptoAdder::initialize(int stage)
+{
+    PacketFlowBase::initialize(stage);
+    if (stage == INITSTAGE_LOCAL) {
+        freshnessLength = par("freshnessLength").intValue();
+        if (freshnessLength < 0 || freshnessLength > 8)
+            throw cRuntimeError("freshnessLength must be between 0 and 8 bytes");
+        trailerLength = B(par("trailerLength").intValue() + freshnessLength);
+        auto trailer = makeShared<ByteCountChunk>(trailerLength);
+        trailer->markImmutable();
+        cryptoTrailer = trailer;
+        addTimeTag = par("addTimeTag").boolValue();
+        recordStageTiming = par("recordStageTiming").boolValue();
+        WATCH(freshnessCounter);
+    }
+}
+
 void CryptoAdder::processPacket(Packet *packet) {
-    auto cryptoTrailer = makeShared<ByteCountChunk>(B(par("trailerLength").intValue()));
     packet->insertAtBack(cryptoTrailer);
+    if (freshnessLength > 0) {
+        auto freshnessTag = packet->addRegionTag<FreshnessTag>();
+        freshnessTag->setStreamId(getId());
+        freshnessTag->setCounter(freshnessCounter++);
+    }
+    if (addTimeTag)
+        packet->addRegionTag<CryptoTimeTag>()->setProtectionTime(simTime());
+    if (recordStageTiming)
+        markTimingStage(packet, TIMING_STAGE_CRYPTO);
 }
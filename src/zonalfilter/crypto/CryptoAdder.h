@@ -16,6 +16,7 @@
 #ifndef __ZONALFILTER_CRYPTOADDER_H_
 #define __ZONALFILTER_CRYPTOADDER_H_
 
+#include "inet/common/packet/chunk/ByteCountChunk.h"
 #include "inet/queueing/base/PacketFlowBase.h"
 #include <omnetpp.h>
 
@@ -24,12 +25,33 @@ using namespace inet;
 using namespace queueing;
 
 /**
- * TODO - Generated class
+ * Appends a crypto trailer (MAC / signature) of trailerLength bytes to every
+ * packet. The trailer carries no data, so a single immutable chunk is created
+ * at initialization and shared by all packets. Packet::insertAtBack() still
+ * allocates per packet: the packet content is immutable, so it is replaced by
+ * a new chunk (a SequenceChunk, or a merged ByteCountChunk) holding the
+ * trailer.
+ *
+ * With freshnessLength > 0 the trailer also carries a freshness value of that
+ * many bytes for replay protection: a per-sender message counter, attached
+ * to the packet as a FreshnessTag and checked by the receiving CryptoRemover.
+ *
+ * Optionally adds a CryptoTimeTag, e.g. for the firewall capture, and marks
+ * the end of the sender's crypto stage in the StageTimingTag.
  */
 class CryptoAdder : public PacketFlowBase
 {
   protected:
-    virtual void processPacket(Packet *packet);
+    B trailerLength = B(0);
+    Ptr<const ByteCountChunk> cryptoTrailer;
+    int freshnessLength = 0;
+    uint64_t freshnessCounter = 0;
+    bool addTimeTag = false;
+    bool recordStageTiming = false;
+
+  protected:
+    virtual void initialize(int stage) override;
+    virtual void processPacket(Packet *packet) override;
 };
 
 #endif
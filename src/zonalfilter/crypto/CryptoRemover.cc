@@ -14,11 +14,77 @@
 // 
 
 #include "CryptoRemover.h"
-#include "inet/common/packet/chunk/ByteCountChunk.h"
+#include "zonalfilter/crypto/FreshnessTag_m.h"
+#include "zonalfilter/timing/StageTiming.h"
 
 Define_Module(CryptoRemover);
 
-void CryptoRemover::processPacket(Packet *packet) {
-    packet->popAtBack<ByteCountChunk>(B(par("trailerLength").intValue()));
+void CryptoRemover::initialize(int stage)
+{
+    PacketFlowBase::initialize(stage);
+    if (stage == INITSTAGE_LOCAL) {
+        freshnessLength = par("freshnessLength").intValue();
+        if (freshnessLength < 0 || freshnessLength > 8)
+            throw cRuntimeError("freshnessLength must be between 0 and 8 bytes");
+        trailerLength = B(par("trailerLength").intValue() + freshnessLength);
+        replayWindowSize = par("replayWindowSize").intValue();
+        recordStageTiming = par("recordStageTiming").boolValue();
+        if (freshnessLength > 0 && (replayWindowSize < 1 || (freshnessLength < 8 && (uint64_t)replayWindowSize > ((uint64_t)1 << (8 * freshnessLength - 1)))))
+            throw cRuntimeError("replayWindowSize must be between 1 and half the range of the freshness value");
+        WATCH(numReplayed);
+        WATCH(numTooOld);
+    }
+}
+
+void CryptoRemover::pushPacket(Packet *packet, cGate *gate)
+{
+    Enter_Method("pushPacket");
+    // Ends the transmission from the last hop, the crypto stage starts.
+    if (recordStageTiming)
+        markTimingStage(packet, TIMING_STAGE_OTHER);
+    if (freshnessLength > 0 && !checkFreshness(packet)) {
+        take(packet);
+        dropPacket(packet, OTHER_PACKET_DROP);
+        return;
+    }
+    PacketFlowBase::pushPacket(packet, gate);
 }
 
+bool CryptoRemover::checkFreshness(Packet *packet)
+{
+    const FreshnessTag *freshnessTag = nullptr;
+    packet->mapAllRegionTags<FreshnessTag>(b(0), packet->getDataLength(), [&] (b, b, const Ptr<const FreshnessTag>& tag) {
+        freshnessTag = tag.get();
+    });
+    if (freshnessTag == nullptr)
+        throw cRuntimeError("Packet %s has no freshness value, is freshnessLength set for the sender?", packet->getName());
+    auto it = replayWindows.find(freshnessTag->getStreamId());
+    if (it == replayWindows.end())
+        it = replayWindows.emplace(freshnessTag->getStreamId(), ReplayWindow(replayWindowSize)).first;
+    auto& replayWindow = it->second;
+    // Only the low bits of the counter are on the wire.
+    int counterBits = 8 * freshnessLength;
+    uint64_t counter = freshnessTag->getCounter();
+    if (counterBits < 64)
+        counter = replayWindow.reconstruct(counter & (((uint64_t)1 << counterBits) - 1), counterBits);
+    switch (replayWindow.check(counter)) {
+        case ReplayWindow::ACCEPTED:
+            return true;
+        case ReplayWindow::REPLAYED:
+            EV_WARN << "Dropping replayed packet" << EV_FIELD(packet) << EV_FIELD(counter) << EV_ENDL;
+            numReplayed++;
+            return false;
+        case ReplayWindow::TOO_OLD:
+            EV_WARN << "Dropping packet older than the replay window" << EV_FIELD(packet) << EV_FIELD(counter) << EV_ENDL;
+            numTooOld++;
+            return false;
+    }
+    return false;
+}
+
+void CryptoRemover::processPacket(Packet *packet) {
+    if (packet->getDataLength() < trailerLength)
+        throw cRuntimeError("Packet %s is shorter than the crypto trailer", packet->getName());
+    // Equivalent to popAtBack() without peeking (and allocating) the trailer chunk.
+    packet->setBackOffset(packet->getBackOffset() - trailerLength);
+}
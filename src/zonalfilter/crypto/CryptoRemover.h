@@ -17,19 +17,44 @@
 #define __ZONALFILTER_CRYPTOREMOVER_H_
 
 #include "inet/queueing/base/PacketFlowBase.h"
+#include "zonalfilter/crypto/ReplayWindow.h"
 #include <omnetpp.h>
+#include <unordered_map>
 
 using namespace omnetpp;
 using namespace inet;
 using namespace queueing;
 
 /**
- * TODO - Generated class
+ * Strips the crypto trailer added by CryptoAdder. The trailer length is read
+ * once at initialization and the trailer is dropped by moving the packet's
+ * back offset, so no chunk is created per packet.
+ *
+ * With freshnessLength > 0 the trailer also carries the sender's freshness
+ * value (see CryptoAdder), which is checked against a sliding replay window
+ * per stream; replayed packets and packets older than the window are
+ * dropped. Only the window of a new stream is allocated, the check itself is
+ * O(1) and allocation free.
  */
 class CryptoRemover : public PacketFlowBase
 {
   protected:
-    virtual void processPacket(Packet *packet);
+    b trailerLength = b(0);
+    int freshnessLength = 0;
+    int replayWindowSize = 0;
+    bool recordStageTiming = false;
+    std::unordered_map<int, ReplayWindow> replayWindows; // by stream ID
+
+    int numReplayed = 0;
+    int numTooOld = 0;
+
+  protected:
+    virtual void initialize(int stage) override;
+    virtual void processPacket(Packet *packet) override;
+    virtual bool checkFreshness(Packet *packet);
+
+  public:
+    virtual void pushPacket(Packet *packet, cGate *gate) override;
 };
 
 #endif
@@ -0,0 +1,65 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "ReplayWindow.h"
+
+ReplayWindow::ReplayWindow(uint64_t windowSize) :
+    windowSize(windowSize)
+{
+    // One block more than the window needs, so that the block of the newest
+    // counter never overlaps the oldest one still inside the window.
+    uint64_t numBlocks = 2;
+    while (numBlocks < (windowSize + 63) / 64 + 1)
+        numBlocks *= 2;
+    blockMask = numBlocks - 1;
+    blocks.assign(numBlocks, 0);
+}
+
+ReplayWindow::Result ReplayWindow::check(uint64_t counter)
+{
+    if (empty) {
+        empty = false;
+        top = counter;
+    }
+    else if (counter > top) {
+        uint64_t index = counter >> 6;
+        uint64_t topIndex = top >> 6;
+        uint64_t numCleared = index - topIndex > blockMask + 1 ? blockMask + 1 : index - topIndex;
+        for (uint64_t i = 1; i <= numCleared; i++)
+            blocks[(topIndex + i) & blockMask] = 0;
+        top = counter;
+    }
+    else if (top - counter >= windowSize)
+        return TOO_OLD;
+    uint64_t& block = blocks[(counter >> 6) & blockMask];
+    uint64_t bit = (uint64_t)1 << (counter & 63);
+    if (block & bit)
+        return REPLAYED;
+    block |= bit;
+    return ACCEPTED;
+}
+
+uint64_t ReplayWindow::reconstruct(uint64_t truncatedCounter, int counterBits) const
+{
+    if (counterBits >= 64 || empty)
+        return truncatedCounter;
+    uint64_t range = (uint64_t)1 << counterBits;
+    uint64_t counter = (top & ~(range - 1)) | truncatedCounter;
+    if (counter + range / 2 < top)
+        counter += range;
+    else if (counter > top + range / 2 && counter >= range)
+        counter -= range;
+    return counter;
+}
@@ -0,0 +1,62 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_REPLAYWINDOW_H_
+#define __ZONALFILTER_REPLAYWINDOW_H_
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Sliding anti-replay window over 64-bit freshness counters, kept as a ring
+ * of 64-bit bitmap blocks (RFC 6479). Checking a counter is O(1): advancing
+ * the window only clears whole blocks, and never more than the ring holds.
+ * The ring is allocated once by the constructor.
+ */
+class ReplayWindow
+{
+  public:
+    enum Result { ACCEPTED, REPLAYED, TOO_OLD };
+
+  protected:
+    uint64_t windowSize;
+    uint64_t blockMask;
+    std::vector<uint64_t> blocks;
+    uint64_t top = 0; // largest accepted counter
+    bool empty = true;
+
+  public:
+    /**
+     * Accepts counters down to windowSize - 1 below the largest accepted one.
+     */
+    explicit ReplayWindow(uint64_t windowSize);
+
+    /**
+     * Checks the counter and, if accepted, marks it as seen.
+     */
+    Result check(uint64_t counter);
+
+    /**
+     * Reconstructs a full counter from its lowest counterBits bits (the
+     * truncated freshness value on the wire): the candidate closest to the
+     * largest accepted counter.
+     */
+    uint64_t reconstruct(uint64_t truncatedCounter, int counterBits) const;
+
+    uint64_t getWindowSize() const { return windowSize; }
+    uint64_t getTop() const { return top; }
+};
+
+#endif
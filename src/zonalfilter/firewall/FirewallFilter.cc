@@ -15,9 +15,11 @@
 
 #include "zonalfilter/firewall/FirewallFilter.h"
 #include "inet/linklayer/common/InterfaceTag_m.h"
-#include "zonalfilter/firewall/TypeTag_m.h"
+#include "zonalfilter/firewall/TypeTagger.h"
+#include "zonalfilter/timing/StageTiming.h"
 #include "inet/networklayer/common/NetworkInterface.h"
 #include <omnetpp.h>
+#include <stdexcept>
 
 using namespace omnetpp;
 
@@ -28,7 +30,17 @@ void FirewallFilter::initialize(int stage)
     PacketFilterBase::initialize(stage);
     if (stage == INITSTAGE_LOCAL) {
         interfaceTable.reference(this, "interfaceTableModule", true);
+        capture.reference(this, "captureModule", false);
         rules = check_and_cast<cValueMap *>(par("rules").objectValue());
+        isIngress = par("isIngress").boolValue();
+        recordStageTiming = par("recordStageTiming").boolValue();
+        parseRules();
+        try {
+            ruleEngine.build(par("classifier").stdstringValue());
+        }
+        catch (std::logic_error& e) {
+            throw cRuntimeError("%s", e.what());
+        }
         WATCH(rules);
     }
 }
@@ -43,54 +55,49 @@ cGate *FirewallFilter::getRegistrationForwardingGate(cGate *gate)
         throw cRuntimeError("Unknown gate");
 }
 
-// inoutkey is either "in" or "out"
-bool FirewallFilter::_checkRules(const char *interfaceName, const char *type, const char *inoutkey) const
-{
-    if (!rules->containsKey(interfaceName)) {
-        return true; // If no entry for the interface exists, assume OK (not enforced)
-    }
-
-    cValueMap *interfaceRules = check_and_cast<cValueMap *>(rules->get(interfaceName).objectValue());
-
-    if (!interfaceRules->containsKey(inoutkey)) {
-        return false; // If no entry for "out" / "in" exists, assume none allowed out
-    }
-
-    cValueArray *inoutRules = check_and_cast<cValueArray *>(interfaceRules->get(inoutkey).objectValue());
-
-    for (int i = 0; i < inoutRules->size(); i++) {
-        if (strcmp(inoutRules->get(i).stringValue(), type) == 0) {
-            return true; // Found message type in in/out table.
-        }
-    }
-    return false; // If no entry for the type exists in the in/out table, block it.
-}
-
-bool FirewallFilter::checkRulesIn(const char *interfaceName, const char *type) const
+void FirewallFilter::pushPacket(Packet *packet, cGate *gate)
 {
-    return _checkRules(interfaceName, type, "in");
+    Enter_Method("pushPacket");
+    // The ingress filter ends the transmission from the ECU; the time until
+    // the egress filter is spent in the firewall processing delay layers.
+    if (recordStageTiming)
+        markTimingStage(packet, isIngress ? TIMING_STAGE_OTHER : TIMING_STAGE_FIREWALL);
+    PacketFilterBase::pushPacket(packet, gate);
 }
 
-bool FirewallFilter::checkRulesOut(const char *interfaceName, const char *type) const
+void FirewallFilter::parseRules()
 {
-    return _checkRules(interfaceName, type, "out");
+    for (const auto& interfaceEntry : rules->getFields()) {
+        const auto& interfaceName = interfaceEntry.first;
+        cValueMap *interfaceRules = check_and_cast<cValueMap *>(interfaceEntry.second.objectValue());
+        ruleEngine.addInterface(interfaceName);
+
+        // A missing "in" / "out" entry leaves that direction blocked entirely.
+        for (auto direction : { FirewallRuleEngine::IN, FirewallRuleEngine::OUT }) {
+            const char *inoutkey = direction == FirewallRuleEngine::IN ? "in" : "out";
+            if (!interfaceRules->containsKey(inoutkey))
+                continue;
+            cValueArray *inoutRules = check_and_cast<cValueArray *>(interfaceRules->get(inoutkey).objectValue());
+            std::vector<std::string> types;
+            for (int i = 0; i < inoutRules->size(); i++)
+                types.push_back(inoutRules->get(i).stringValue());
+            ruleEngine.setAllowedTypes(interfaceName, direction, types);
+        }
+    }
 }
 
-bool FirewallFilter::checkRules(const char *interfaceName, const char *type) const
+bool FirewallFilter::checkRules(FirewallRuleEngine::InterfaceId interface, FirewallRuleEngine::TypeId type) const
 {
-    if (par("isIngress").boolValue())
-    {
-        // Confusing naming - here, we are checking that the message can leave
-        // the given ECU ("Out"), meaning that it's ingressing into the switch.
-        return checkRulesOut(interfaceName, type);
-    }
-    return checkRulesIn(interfaceName, type);
+    // Confusing naming - for an ingress filter, we are checking that the message can leave
+    // the given ECU ("Out"), meaning that it's ingressing into the switch.
+    auto direction = isIngress ? FirewallRuleEngine::OUT : FirewallRuleEngine::IN;
+    return ruleEngine.check(interface, direction, type);
 }
 
-const char * FirewallFilter::getInterfaceName(const Packet *packet) const
+NetworkInterface * FirewallFilter::getNetworkInterface(const Packet *packet) const
 {
     NetworkInterface * networkInterface;
-    if (par("isIngress").boolValue())
+    if (isIngress)
     {
         auto interfaceInd = packet->findTag<InterfaceInd>();
         networkInterface = interfaceInd != nullptr ?
@@ -102,33 +109,58 @@ const char * FirewallFilter::getInterfaceName(const Packet *packet) const
         networkInterface = interfaceReq != nullptr ?
                 interfaceTable->getInterfaceById(interfaceReq->getInterfaceId()) : nullptr;
     }
+    return networkInterface;
+}
 
-    auto interfaceName = networkInterface != nullptr ?
-            networkInterface->getInterfaceName() : "";
+FirewallRuleEngine::InterfaceId FirewallFilter::getInterfaceId(const NetworkInterface *networkInterface) const
+{
+    if (networkInterface == nullptr)
+        return FirewallRuleEngine::UNKNOWN;
+    auto it = interfaceIds.find(networkInterface->getInterfaceId());
+    if (it == interfaceIds.end())
+        it = interfaceIds.emplace(networkInterface->getInterfaceId(), ruleEngine.findInterface(networkInterface->getInterfaceName())).first;
+    return it->second;
+}
 
-    return interfaceName;
+FirewallRuleEngine::TypeId FirewallFilter::getTypeId(const TypeTag *typeTag) const
+{
+    int typeId = typeTag->getTypeId();
+    if (typeId < 0)
+        return ruleEngine.findType(typeTag->getType()); // not added by a TypeTagger
+    while ((int)typeIds.size() <= typeId)
+        typeIds.push_back(ruleEngine.findType(TypeTagger::getTypeName(typeIds.size())));
+    return typeIds[typeId];
 }
 
 bool FirewallFilter::matchesPacket(const Packet *packet) const
 {
-    auto interfaceName = getInterfaceName(packet);
+    auto networkInterface = getNetworkInterface(packet);
+    auto interfaceName = networkInterface != nullptr ?
+            networkInterface->getInterfaceName() : "";
 
-    if (strcmp(interfaceName, "") == 0) {
+    if (networkInterface == nullptr) {
         EV_WARN << "Unknown incoming interface!";
     }
 
-    auto typeTags = packet->getAllRegionTags<TypeTag>();
-    if (typeTags.size() == 0) {
+    Ptr<const TypeTag> typeTag;
+    packet->mapAllRegionTags<TypeTag>(b(0), packet->getDataLength(), [&] (b, b, const Ptr<const TypeTag>& tag) {
+        if (typeTag == nullptr)
+            typeTag = tag;
+    });
+    if (typeTag == nullptr) {
+        if (capture != nullptr)
+            capture->captureDecision(packet, interfaceName, nullptr, isIngress, true);
         return true; // Let through untyped traffic, which is likely from other protocols (gPTP, etc.)
                      // that we're not trying to mess with.
                      // For security purposes, we can assume ECUs would only accept typed messages
                      // for actual control reasons, etc.
     }
-    auto typeTag = typeTags[0].getTag();
     auto typeStr = typeTag->getType();
 
-    bool result = checkRules(interfaceName, typeStr);
-    const char * ingressEgressStr = par("isIngress").boolValue() ? "(INGRESS)" : "(EGRESS)";
+    bool result = checkRules(getInterfaceId(networkInterface), getTypeId(typeTag.get()));
+    if (capture != nullptr)
+        capture->captureDecision(packet, interfaceName, typeStr, isIngress, result);
+    const char * ingressEgressStr = isIngress ? "(INGRESS)" : "(EGRESS)";
     if (result)
     {
         EV_DEBUG << ingressEgressStr << " " << "Packet ok";
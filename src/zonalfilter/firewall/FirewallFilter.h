@@ -21,6 +21,11 @@
 #include "inet/common/ModuleRefByPar.h"
 #include "inet/common/IProtocolRegistrationListener.h"
 #include "inet/networklayer/contract/IInterfaceTable.h"
+#include "zonalfilter/capture/FirewallCapture.h"
+#include "zonalfilter/firewall/TypeTag_m.h"
+#include "zonalfilter/firewall/engine/FirewallRuleEngine.h"
+#include <unordered_map>
+#include <vector>
 
 using namespace inet::queueing;
 using namespace inet;
@@ -29,21 +34,31 @@ class FirewallFilter : public PacketFilterBase, public TransparentProtocolRegist
 {
   protected:
     ModuleRefByPar<IInterfaceTable> interfaceTable;
+    ModuleRefByPar<FirewallCapture> capture;
     cValueMap *rules = nullptr;
+    bool isIngress = false;
+    bool recordStageTiming = false;
+    FirewallRuleEngine ruleEngine;
+
+    // rule engine IDs, resolved on the first packet of every interface / type
+    mutable std::unordered_map<int, FirewallRuleEngine::InterfaceId> interfaceIds; // by NetworkInterface ID
+    mutable std::vector<FirewallRuleEngine::TypeId> typeIds; // by TypeTag type ID
 
   private:
-    bool _checkRules(const char *interfaceName, const char *type, const char *inoutkey) const;
-    bool checkRulesIn(const char *interfaceName, const char *type) const;
-    bool checkRulesOut(const char *interfaceName, const char *type) const;
-    bool checkRules(const char *interfaceName, const char *type) const;
+    void parseRules();
+    bool checkRules(FirewallRuleEngine::InterfaceId interface, FirewallRuleEngine::TypeId type) const;
 
-    const char * getInterfaceName(const Packet * packet) const;
+    NetworkInterface * getNetworkInterface(const Packet * packet) const;
+    FirewallRuleEngine::InterfaceId getInterfaceId(const NetworkInterface *networkInterface) const;
+    FirewallRuleEngine::TypeId getTypeId(const TypeTag *typeTag) const;
 
   protected:
     virtual void initialize(int stage) override;
 
     virtual cGate *getRegistrationForwardingGate(cGate *gate) override;
 
+    virtual void pushPacket(Packet *packet, cGate *gate) override;
+
     virtual bool matchesPacket(const Packet *packet) const override;
 
 };
@@ -178,18 +178,21 @@ TypeTag& TypeTag::operator=(const TypeTag& other)
 void TypeTag::copy(const TypeTag& other)
 {
     this->type = other.type;
+    this->typeId = other.typeId;
 }
 
 void TypeTag::parsimPack(omnetpp::cCommBuffer *b) const
 {
     ::inet::TagBase::parsimPack(b);
     doParsimPacking(b,this->type);
+    doParsimPacking(b,this->typeId);
 }
 
 void TypeTag::parsimUnpack(omnetpp::cCommBuffer *b)
 {
     ::inet::TagBase::parsimUnpack(b);
     doParsimUnpacking(b,this->type);
+    doParsimUnpacking(b,this->typeId);
 }
 
 const char * TypeTag::getType() const
@@ -202,12 +205,23 @@ void TypeTag::setType(const char * type)
     this->type = type;
 }
 
+int TypeTag::getTypeId() const
+{
+    return this->typeId;
+}
+
+void TypeTag::setTypeId(int typeId)
+{
+    this->typeId = typeId;
+}
+
 class TypeTagDescriptor : public omnetpp::cClassDescriptor
 {
   private:
     mutable const char **propertyNames;
     enum FieldConstants {
         FIELD_type,
+        FIELD_typeId,
     };
   public:
     TypeTagDescriptor();
@@ -274,7 +288,7 @@ const char *TypeTagDescriptor::getProperty(const char *propertyName) const
 int TypeTagDescriptor::getFieldCount() const
 {
     omnetpp::cClassDescriptor *base = getBaseClassDescriptor();
-    return base ? 1+base->getFieldCount() : 1;
+    return base ? 2+base->getFieldCount() : 2;
 }
 
 unsigned int TypeTagDescriptor::getFieldTypeFlags(int field) const
@@ -287,8 +301,9 @@ unsigned int TypeTagDescriptor::getFieldTypeFlags(int field) const
     }
     static unsigned int fieldTypeFlags[] = {
         FD_ISEDITABLE,    // FIELD_type
+        FD_ISEDITABLE,    // FIELD_typeId
     };
-    return (field >= 0 && field < 1) ? fieldTypeFlags[field] : 0;
+    return (field >= 0 && field < 2) ? fieldTypeFlags[field] : 0;
 }
 
 const char *TypeTagDescriptor::getFieldName(int field) const
@@ -301,8 +316,9 @@ const char *TypeTagDescriptor::getFieldName(int field) const
     }
     static const char *fieldNames[] = {
         "type",
+        "typeId",
     };
-    return (field >= 0 && field < 1) ? fieldNames[field] : nullptr;
+    return (field >= 0 && field < 2) ? fieldNames[field] : nullptr;
 }
 
 int TypeTagDescriptor::findField(const char *fieldName) const
@@ -310,6 +326,7 @@ int TypeTagDescriptor::findField(const char *fieldName) const
     omnetpp::cClassDescriptor *base = getBaseClassDescriptor();
     int baseIndex = base ? base->getFieldCount() : 0;
     if (strcmp(fieldName, "type") == 0) return baseIndex + 0;
+    if (strcmp(fieldName, "typeId") == 0) return baseIndex + 1;
     return base ? base->findField(fieldName) : -1;
 }
 
@@ -323,8 +340,9 @@ const char *TypeTagDescriptor::getFieldTypeString(int field) const
     }
     static const char *fieldTypeStrings[] = {
         "string",    // FIELD_type
+        "int",    // FIELD_typeId
     };
-    return (field >= 0 && field < 1) ? fieldTypeStrings[field] : nullptr;
+    return (field >= 0 && field < 2) ? fieldTypeStrings[field] : nullptr;
 }
 
 const char **TypeTagDescriptor::getFieldPropertyNames(int field) const
@@ -408,6 +426,7 @@ std::string TypeTagDescriptor::getFieldValueAsString(omnetpp::any_ptr object, in
     TypeTag *pp = omnetpp::fromAnyPtr<TypeTag>(object); (void)pp;
     switch (field) {
         case FIELD_type: return oppstring2string(pp->getType());
+        case FIELD_typeId: return long2string(pp->getTypeId());
         default: return "";
     }
 }
@@ -425,6 +444,7 @@ void TypeTagDescriptor::setFieldValueAsString(omnetpp::any_ptr object, int field
     TypeTag *pp = omnetpp::fromAnyPtr<TypeTag>(object); (void)pp;
     switch (field) {
         case FIELD_type: pp->setType((value)); break;
+        case FIELD_typeId: pp->setTypeId(string2long(value)); break;
         default: throw omnetpp::cRuntimeError("Cannot set field %d of class 'TypeTag'", field);
     }
 }
@@ -440,6 +460,7 @@ omnetpp::cValue TypeTagDescriptor::getFieldValue(omnetpp::any_ptr object, int fi
     TypeTag *pp = omnetpp::fromAnyPtr<TypeTag>(object); (void)pp;
     switch (field) {
         case FIELD_type: return pp->getType();
+        case FIELD_typeId: return pp->getTypeId();
         default: throw omnetpp::cRuntimeError("Cannot return field %d of class 'TypeTag' as cValue -- field index out of range?", field);
     }
 }
@@ -457,6 +478,7 @@ void TypeTagDescriptor::setFieldValue(omnetpp::any_ptr object, int field, int i,
     TypeTag *pp = omnetpp::fromAnyPtr<TypeTag>(object); (void)pp;
     switch (field) {
         case FIELD_type: pp->setType(value.stringValue()); break;
+        case FIELD_typeId: pp->setTypeId(omnetpp::checked_int_cast<int>(value.intValue())); break;
         default: throw omnetpp::cRuntimeError("Cannot set field %d of class 'TypeTag'", field);
     }
 }
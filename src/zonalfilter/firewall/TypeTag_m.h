@@ -36,6 +36,7 @@ namespace inet {
  * class TypeTag extends TagBase
  * {
  *     string type;
+ *     int typeId = -1; // TypeTagger::getTypeId() of type, -1 if not interned
  * }
  * </pre>
  */
@@ -43,6 +44,7 @@ class TypeTag : public ::inet::TagBase
 {
   protected:
     ::omnetpp::opp_string type;
+    int typeId = -1;
 
   private:
     void copy(const TypeTag& other);
@@ -61,6 +63,9 @@ class TypeTag : public ::inet::TagBase
 
     virtual const char * getType() const;
     virtual void setType(const char * type);
+
+    virtual int getTypeId() const;
+    virtual void setTypeId(int typeId);
 };
 
 inline void doParsimPacking(omnetpp::cCommBuffer *b, const TypeTag& obj) {obj.parsimPack(b);}
@@ -15,16 +15,47 @@
 
 #include "zonalfilter/firewall/TypeTagger.h"
 #include "zonalfilter/firewall/TypeTag_m.h"
+#include <deque>
+#include <unordered_map>
 
 Define_Module(TypeTagger);
 
+static std::unordered_map<std::string, int> typeIds;
+static std::deque<std::string> typeNames; // stable c_str() pointers
+
+int TypeTagger::getTypeId(const char *type)
+{
+    auto it = typeIds.find(type);
+    if (it != typeIds.end())
+        return it->second;
+    int typeId = typeNames.size();
+    typeNames.push_back(type);
+    typeIds[type] = typeId;
+    return typeId;
+}
+
+const char *TypeTagger::getTypeName(int typeId)
+{
+    return typeNames.at(typeId).c_str();
+}
+
+int TypeTagger::getNumTypeIds()
+{
+    return typeNames.size();
+}
+
 void TypeTagger::initialize(int stage)
 {
     PacketMarkerBase::initialize(stage);
+    if (stage == INITSTAGE_LOCAL) {
+        type = par("type").stdstringValue();
+        typeId = getTypeId(type.c_str());
+    }
 }
 
 void TypeTagger::markPacket(Packet *packet)
 {
     auto typeTag = packet->addRegionTag<TypeTag>();
-    typeTag->setType(par("type").stringValue());
+    typeTag->setType(type.c_str());
+    typeTag->setTypeId(typeId);
 }
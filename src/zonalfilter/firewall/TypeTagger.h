@@ -17,14 +17,33 @@
 #define __ZONALFILTER_TYPETAGGER_H_
 
 #include "inet/queueing/base/PacketMarkerBase.h"
+#include <string>
 
 using namespace inet;
 
+/**
+ * Adds a TypeTag with the configured type to every packet. The tag also
+ * carries a process-wide ID of the type name (see getTypeId()), so that
+ * the firewall filters can look the type up without hashing its name.
+ */
 class TypeTagger : public queueing::PacketMarkerBase
 {
+  protected:
+    std::string type;
+    int typeId = -1;
+
   protected:
     virtual void initialize(int stage) override;
     virtual void markPacket(Packet *packet) override;
+
+  public:
+    /**
+     * Returns the dense ID of the type name, adding it if it's not known
+     * yet. IDs are shared by all modules and stay valid for the process.
+     */
+    static int getTypeId(const char *type);
+    static const char *getTypeName(int typeId);
+    static int getNumTypeIds();
 };
 
 #endif
@@ -0,0 +1,190 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/firewall/engine/DecisionTreeClassifier.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+void DecisionTreeClassifier::build(const std::vector<Rule>& rules, uint32_t numKeys, uint32_t typeLimit)
+{
+    this->rules = rules;
+    this->typeLimit = typeLimit;
+    nodes.clear();
+    children.clear();
+    leafRules.clear();
+    depth = 0;
+    Box box;
+    box.low[0] = 0;
+    box.high[0] = std::max(numKeys, 1u) - 1;
+    box.low[1] = 0;
+    box.high[1] = std::max(typeLimit, 1u) - 1;
+    std::vector<uint32_t> ruleIndices(rules.size());
+    for (uint32_t i = 0; i < rules.size(); i++)
+        ruleIndices[i] = i;
+    buildNode(box, ruleIndices, 0);
+    // Only the tree is needed for lookups.
+    std::vector<Rule>().swap(this->rules);
+}
+
+uint32_t DecisionTreeClassifier::getValue(const Rule& rule, int dimension, bool high)
+{
+    if (dimension == 0)
+        return rule.key;
+    return high ? rule.lastType : rule.firstType;
+}
+
+uint32_t DecisionTreeClassifier::makeLeaf(const std::vector<uint32_t>& ruleIndices)
+{
+    Node leaf;
+    leaf.first = leafRules.size();
+    leaf.count = ruleIndices.size();
+    for (uint32_t index : ruleIndices)
+        leafRules.push_back(rules[index]);
+    nodes.push_back(leaf);
+    return nodes.size() - 1;
+}
+
+int DecisionTreeClassifier::chooseDimension(const Box& box, const std::vector<uint32_t>& ruleIndices) const
+{
+    int bestDimension = -1;
+    size_t bestCount = 0;
+    for (int dimension = 0; dimension < 2; dimension++) {
+        if (box.low[dimension] == box.high[dimension])
+            continue;
+        std::vector<std::pair<uint32_t, uint32_t>> projections;
+        projections.reserve(ruleIndices.size());
+        for (uint32_t index : ruleIndices) {
+            uint32_t low = std::max(getValue(rules[index], dimension, false), box.low[dimension]);
+            uint32_t high = std::min(getValue(rules[index], dimension, true), box.high[dimension]);
+            projections.emplace_back(low, high);
+        }
+        std::sort(projections.begin(), projections.end());
+        size_t count = std::unique(projections.begin(), projections.end()) - projections.begin();
+        if (count > bestCount) {
+            bestCount = count;
+            bestDimension = dimension;
+        }
+    }
+    return bestCount > 1 ? bestDimension : -1;
+}
+
+int DecisionTreeClassifier::chooseShift(const Box& box, int dimension, const std::vector<uint32_t>& ruleIndices) const
+{
+    uint64_t width = (uint64_t)box.high[dimension] - box.low[dimension] + 1;
+    int widthBits = 0;
+    while (((uint64_t)1 << widthBits) < width)
+        widthBits++;
+    // Start with two cells and double them while the cost (cells plus rule
+    // copies) stays within the space budget.
+    double budget = spaceFactor * ruleIndices.size();
+    int shift = widthBits - 1;
+    while (shift > 0 && widthBits - (shift - 1) <= 16) {
+        int candidate = shift - 1;
+        uint64_t cost = ((width - 1) >> candidate) + 1;
+        for (uint32_t index : ruleIndices) {
+            uint32_t low = std::max(getValue(rules[index], dimension, false), box.low[dimension]);
+            uint32_t high = std::min(getValue(rules[index], dimension, true), box.high[dimension]);
+            cost += ((uint64_t)(high - box.low[dimension]) >> candidate) - ((uint64_t)(low - box.low[dimension]) >> candidate) + 1;
+        }
+        if (cost > budget)
+            break;
+        shift = candidate;
+    }
+    return shift;
+}
+
+uint32_t DecisionTreeClassifier::buildNode(const Box& box, const std::vector<uint32_t>& ruleIndices, int depth)
+{
+    this->depth = std::max(this->depth, depth);
+    if (ruleIndices.size() <= leafSize || depth >= maxDepth)
+        return makeLeaf(ruleIndices);
+    int dimension = chooseDimension(box, ruleIndices);
+    if (dimension == -1)
+        return makeLeaf(ruleIndices); // identical rules, cutting cannot separate them
+
+    uint32_t low = box.low[dimension];
+    uint64_t width = (uint64_t)box.high[dimension] - low + 1;
+    std::vector<std::vector<uint32_t>> cellRules;
+    // Cut finer than the budget if the cells would not separate any rule.
+    for (int shift = chooseShift(box, dimension, ruleIndices); shift >= 0; shift--) {
+        uint64_t numCells = ((width - 1) >> shift) + 1;
+        if (numCells > (1 << 16))
+            break;
+        cellRules.assign(numCells, {});
+        bool progress = false;
+        for (uint32_t index : ruleIndices) {
+            uint32_t first = (std::max(getValue(rules[index], dimension, false), low) - low) >> shift;
+            uint32_t last = (std::min(getValue(rules[index], dimension, true), box.high[dimension]) - low) >> shift;
+            for (uint32_t cell = first; cell <= last; cell++)
+                cellRules[cell].push_back(index);
+        }
+        for (const auto& cell : cellRules)
+            progress = progress || cell.size() < ruleIndices.size();
+        if (!progress)
+            continue;
+
+        uint32_t nodeIndex = nodes.size();
+        nodes.emplace_back();
+        std::vector<uint32_t> childIndices(numCells);
+        for (uint32_t cell = 0; cell < numCells;) {
+            // Identical siblings share one child, built over the box of the
+            // whole run, so that its cuts cover every value of the run.
+            uint32_t end = cell + 1;
+            while (end < numCells && cellRules[end] == cellRules[cell])
+                end++;
+            Box childBox = box;
+            childBox.low[dimension] = low + ((uint64_t)cell << shift);
+            childBox.high[dimension] = std::min<uint64_t>(box.high[dimension], low + ((uint64_t)end << shift) - 1);
+            uint32_t childIndex = buildNode(childBox, cellRules[cell], depth + 1);
+            for (; cell < end; cell++)
+                childIndices[cell] = childIndex;
+        }
+        Node& node = nodes[nodeIndex];
+        node.dimension = dimension;
+        node.shift = shift;
+        node.low = low;
+        node.first = children.size();
+        node.count = numCells;
+        children.insert(children.end(), childIndices.begin(), childIndices.end());
+        return nodeIndex;
+    }
+    return makeLeaf(ruleIndices);
+}
+
+bool DecisionTreeClassifier::matches(uint32_t key, uint32_t type) const
+{
+    if (type >= typeLimit)
+        return false;
+    const uint32_t values[2] = {key, type};
+    const Node *node = &nodes[0];
+    while (node->dimension != LEAF) {
+        uint32_t cell = (values[node->dimension] - node->low) >> node->shift;
+        assert(cell < node->count);
+        node = &nodes[children[node->first + cell]];
+    }
+    for (uint32_t i = node->first; i < node->first + node->count; i++) {
+        const Rule& rule = leafRules[i];
+        if (rule.key == key && rule.firstType <= type && type <= rule.lastType)
+            return true;
+    }
+    return false;
+}
+
+size_t DecisionTreeClassifier::getMemoryUsage() const
+{
+    return nodes.capacity() * sizeof(Node) + children.capacity() * sizeof(uint32_t) + leafRules.capacity() * sizeof(Rule);
+}
@@ -0,0 +1,81 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_DECISIONTREECLASSIFIER_H_
+#define __ZONALFILTER_DECISIONTREECLASSIFIER_H_
+
+#include "zonalfilter/firewall/engine/FirewallClassifier.h"
+
+/**
+ * HiCuts-style decision tree over the two dimensions (key, type).
+ *
+ * Every inner node cuts its box along one dimension into equally sized,
+ * power of two wide cells, so a lookup descends with a subtraction and a
+ * shift per level and finishes with a linear search over at most
+ * leafSize rules. Following HiCuts, a node is cut along the dimension
+ * with the most distinct rule projections, into as many cells as the
+ * space budget (spaceFactor times the node's rules) allows, and identical
+ * sibling cells share one child.
+ */
+class DecisionTreeClassifier : public FirewallClassifier
+{
+  protected:
+    static const uint8_t LEAF = 0xff;
+
+    struct Box {
+        uint32_t low[2];
+        uint32_t high[2];
+    };
+
+    struct Node {
+        uint8_t dimension = LEAF;
+        uint8_t shift = 0;
+        uint32_t low = 0; // of the cut dimension
+        uint32_t first = 0; // first child index, or first rule of a leaf
+        uint32_t count = 0; // number of children, or rules of a leaf
+    };
+
+    size_t leafSize;
+    double spaceFactor;
+    int maxDepth;
+
+    std::vector<Rule> rules;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> children;
+    std::vector<Rule> leafRules;
+    uint32_t typeLimit = 0;
+    int depth = 0;
+
+  protected:
+    static uint32_t getValue(const Rule& rule, int dimension, bool high);
+    uint32_t buildNode(const Box& box, const std::vector<uint32_t>& ruleIndices, int depth);
+    uint32_t makeLeaf(const std::vector<uint32_t>& ruleIndices);
+    int chooseDimension(const Box& box, const std::vector<uint32_t>& ruleIndices) const;
+    int chooseShift(const Box& box, int dimension, const std::vector<uint32_t>& ruleIndices) const;
+
+  public:
+    DecisionTreeClassifier(size_t leafSize = 8, double spaceFactor = 4, int maxDepth = 24) :
+        leafSize(leafSize), spaceFactor(spaceFactor), maxDepth(maxDepth) {}
+
+    virtual const char *getName() const override { return "tree"; }
+    virtual void build(const std::vector<Rule>& rules, uint32_t numKeys, uint32_t typeLimit) override;
+    virtual bool matches(uint32_t key, uint32_t type) const override;
+    virtual size_t getMemoryUsage() const override;
+
+    size_t getNumNodes() const { return nodes.size(); }
+    int getDepth() const { return depth; }
+};
+
+#endif
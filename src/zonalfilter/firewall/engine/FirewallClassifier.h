@@ -0,0 +1,58 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_FIREWALLCLASSIFIER_H_
+#define __ZONALFILTER_FIREWALLCLASSIFIER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Lookup structure of FirewallRuleEngine: decides whether an allow rule
+ * matches a packet. Enforcement (interfaces without rules etc.) is handled
+ * by the engine, so a classifier only sees allow rules of the form
+ * "key = K and first <= type <= last", where the key combines the
+ * interface and direction of the rule (interface * 2 + direction).
+ */
+class FirewallClassifier
+{
+  public:
+    struct Rule {
+        uint32_t key;
+        uint32_t firstType;
+        uint32_t lastType;
+    };
+
+  public:
+    virtual ~FirewallClassifier() {}
+
+    virtual const char *getName() const = 0;
+
+    /**
+     * Builds the lookup structure. Keys are below numKeys, types below
+     * typeLimit.
+     */
+    virtual void build(const std::vector<Rule>& rules, uint32_t numKeys, uint32_t typeLimit) = 0;
+
+    virtual bool matches(uint32_t key, uint32_t type) const = 0;
+
+    /**
+     * Returns the heap memory used by the lookup structure in bytes.
+     */
+    virtual size_t getMemoryUsage() const = 0;
+};
+
+#endif
@@ -0,0 +1,121 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/firewall/engine/FirewallRuleEngine.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "zonalfilter/firewall/engine/DecisionTreeClassifier.h"
+#include "zonalfilter/firewall/engine/HashClassifier.h"
+#include "zonalfilter/firewall/engine/LinearClassifier.h"
+
+FirewallRuleEngine::InterfaceId FirewallRuleEngine::addInterface(const std::string& interfaceName)
+{
+    auto it = interfaceIds.find(interfaceName);
+    if (it != interfaceIds.end())
+        return it->second;
+    InterfaceId interface = interfaces.size();
+    interfaceIds[interfaceName] = interface;
+    interfaces.emplace_back();
+    return interface;
+}
+
+FirewallRuleEngine::TypeId FirewallRuleEngine::addType(const std::string& typeName)
+{
+    auto it = typeIds.find(typeName);
+    if (it != typeIds.end())
+        return it->second;
+    TypeId type = typeNames.size();
+    typeIds[typeName] = type;
+    typeNames.push_back(typeName);
+    return type;
+}
+
+void FirewallRuleEngine::setAllowedTypes(const std::string& interfaceName, Direction direction, const std::vector<std::string>& allowedTypeNames)
+{
+    InterfaceId interface = addInterface(interfaceName);
+    interfaces[interface].hasRules[direction] = true;
+    for (const auto& typeName : allowedTypeNames) {
+        TypeId type = addType(typeName);
+        rules.push_back({interface * 2 + direction, type, type});
+        typeLimit = std::max(typeLimit, type + 1);
+    }
+}
+
+void FirewallRuleEngine::addAllowedTypes(const std::string& interfaceName, Direction direction, TypeId firstType, TypeId lastType)
+{
+    if (firstType > lastType || lastType >= UNKNOWN)
+        throw std::invalid_argument("invalid type range");
+    InterfaceId interface = addInterface(interfaceName);
+    interfaces[interface].hasRules[direction] = true;
+    rules.push_back({interface * 2 + direction, firstType, lastType});
+    typeLimit = std::max(typeLimit, lastType + 1);
+}
+
+const std::vector<std::string>& FirewallRuleEngine::getClassifierNames()
+{
+    static const std::vector<std::string> names = {"linear", "hash", "tree"};
+    return names;
+}
+
+std::unique_ptr<FirewallClassifier> FirewallRuleEngine::createClassifier(const std::string& classifierName)
+{
+    if (classifierName == "linear")
+        return std::unique_ptr<FirewallClassifier>(new LinearClassifier());
+    else if (classifierName == "hash")
+        return std::unique_ptr<FirewallClassifier>(new HashClassifier());
+    else if (classifierName == "tree")
+        return std::unique_ptr<FirewallClassifier>(new DecisionTreeClassifier());
+    else
+        throw std::invalid_argument("unknown firewall classifier '" + classifierName + "'");
+}
+
+void FirewallRuleEngine::build(const std::string& classifierName)
+{
+    classifier = createClassifier(classifierName);
+    classifier->build(rules, interfaces.size() * 2, typeLimit);
+}
+
+FirewallRuleEngine::InterfaceId FirewallRuleEngine::findInterface(const char *interfaceName) const
+{
+    auto it = interfaceIds.find(interfaceName);
+    return it != interfaceIds.end() ? it->second : UNKNOWN;
+}
+
+FirewallRuleEngine::TypeId FirewallRuleEngine::findType(const char *typeName) const
+{
+    auto it = typeIds.find(typeName);
+    return it != typeIds.end() ? it->second : UNKNOWN;
+}
+
+bool FirewallRuleEngine::check(InterfaceId interface, Direction direction, TypeId type) const
+{
+    if (interface >= interfaces.size()) {
+        return true; // If no entry for the interface exists, assume OK (not enforced)
+    }
+
+    if (!interfaces[interface].hasRules[direction]) {
+        return false; // If no entry for "out" / "in" exists, assume none allowed
+    }
+
+    // Allowed iff the type is in the in/out table; UNKNOWN types never are.
+    return classifier->matches(interface * 2 + direction, type);
+}
+
+bool FirewallRuleEngine::check(const char *interfaceName, Direction direction, const char *typeName) const
+{
+    return check(findInterface(interfaceName), direction, findType(typeName));
+}
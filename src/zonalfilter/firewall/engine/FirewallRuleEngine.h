@@ -0,0 +1,124 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_FIREWALLRULEENGINE_H_
+#define __ZONALFILTER_FIREWALLRULEENGINE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "zonalfilter/firewall/engine/FirewallClassifier.h"
+
+/**
+ * Simulator-independent rule engine of the zonal firewall.
+ *
+ * For every enforced interface, the rules list which message types may go
+ * 'in' (into the ECU on that port) and 'out' (out of the ECU on that port):
+ *
+ *  - traffic on an interface without rules is not enforced (allowed)
+ *  - traffic on an enforced interface in a direction without a rule list
+ *    is blocked
+ *  - otherwise, traffic is allowed iff its type is in the rule list
+ *
+ * Interface and type names are interned to dense integer IDs when the rules
+ * are added, so the per-packet check can run on IDs only (e.g. the type ID
+ * header of a real frame). The string overload is a convenience for callers
+ * that only have names. Rules may also allow ranges of type IDs.
+ *
+ * After all rules are added, build() compiles them into one of the
+ * classifier backends ("linear", "hash" or "tree", see FirewallClassifier),
+ * which all make the same decisions at different lookup cost and memory.
+ */
+class FirewallRuleEngine
+{
+  public:
+    enum Direction {
+        IN = 0,     // into the ECU on the port (egress from the switch)
+        OUT = 1,    // out of the ECU on the port (ingress into the switch)
+    };
+
+    typedef uint32_t InterfaceId;
+    typedef uint32_t TypeId;
+
+    static const uint32_t UNKNOWN = UINT32_MAX;
+
+  protected:
+    struct InterfaceRules {
+        bool hasRules[2] = {false, false};
+    };
+
+    std::unordered_map<std::string, InterfaceId> interfaceIds;
+    std::unordered_map<std::string, TypeId> typeIds;
+    std::vector<std::string> typeNames;
+    std::vector<InterfaceRules> interfaces;
+    std::vector<FirewallClassifier::Rule> rules;
+    TypeId typeLimit = 0; // one past the largest type ID in any rule
+    std::unique_ptr<FirewallClassifier> classifier;
+
+  public:
+    /**
+     * Marks the interface as enforced (all traffic blocked until allowed)
+     * and returns its ID.
+     */
+    InterfaceId addInterface(const std::string& interfaceName);
+
+    /**
+     * Returns the ID of the type, adding it if it's not known yet.
+     */
+    TypeId addType(const std::string& typeName);
+
+    /**
+     * Adds a rule list for the given direction of the interface (which may be
+     * empty, meaning nothing is allowed in that direction).
+     */
+    void setAllowedTypes(const std::string& interfaceName, Direction direction, const std::vector<std::string>& typeNames);
+
+    /**
+     * Allows the type IDs firstType..lastType in the given direction of the
+     * interface, e.g. for IDs assigned outside the engine.
+     */
+    void addAllowedTypes(const std::string& interfaceName, Direction direction, TypeId firstType, TypeId lastType);
+
+    /**
+     * Compiles the rules into the named classifier backend; must be called
+     * after the rules are complete and before check(). Throws
+     * std::invalid_argument for unknown backends.
+     */
+    void build(const std::string& classifierName);
+
+    static std::unique_ptr<FirewallClassifier> createClassifier(const std::string& classifierName);
+    static const std::vector<std::string>& getClassifierNames();
+    const FirewallClassifier *getClassifier() const { return classifier.get(); }
+
+    InterfaceId findInterface(const char *interfaceName) const;
+    TypeId findType(const char *typeName) const;
+    const std::string& getTypeName(TypeId type) const { return typeNames.at(type); }
+    size_t getNumInterfaces() const { return interfaces.size(); }
+    size_t getNumTypes() const { return typeNames.size(); }
+    size_t getNumRules() const { return rules.size(); }
+    TypeId getTypeLimit() const { return typeLimit; }
+
+    /**
+     * Checks a packet of the given type in the given direction of the interface.
+     * UNKNOWN interfaces are not enforced; UNKNOWN types match no rule.
+     */
+    bool check(InterfaceId interface, Direction direction, TypeId type) const;
+    bool check(const char *interfaceName, Direction direction, const char *typeName) const;
+};
+
+#endif
@@ -0,0 +1,60 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/firewall/engine/HashClassifier.h"
+
+#include <stdexcept>
+
+void HashClassifier::build(const std::vector<Rule>& rules, uint32_t /*numKeys*/, uint32_t /*typeLimit*/)
+{
+    size_t numEntries = 0;
+    for (const auto& rule : rules)
+        numEntries += (size_t)rule.lastType - rule.firstType + 1;
+    if (numEntries > MAX_ENTRIES)
+        throw std::length_error("hash classifier: type ranges expand to too many entries");
+    // Keep the load factor at or below 1/2 so probe sequences stay short.
+    int bits = 1;
+    while (((size_t)1 << bits) < 2 * numEntries)
+        bits++;
+    shift = 64 - bits;
+    mask = ((uint64_t)1 << bits) - 1;
+    table.assign((size_t)1 << bits, EMPTY);
+    for (const auto& rule : rules)
+        for (uint64_t type = rule.firstType; type <= rule.lastType; type++)
+            insert(makeEntry(rule.key, type));
+}
+
+void HashClassifier::insert(uint64_t entry)
+{
+    for (size_t slot = getSlot(entry); ; slot = (slot + 1) & mask) {
+        if (table[slot] == entry)
+            return; // overlapping rules
+        if (table[slot] == EMPTY) {
+            table[slot] = entry;
+            return;
+        }
+    }
+}
+
+bool HashClassifier::matches(uint32_t key, uint32_t type) const
+{
+    uint64_t entry = makeEntry(key, type);
+    for (size_t slot = getSlot(entry); ; slot = (slot + 1) & mask) {
+        if (table[slot] == entry)
+            return true;
+        if (table[slot] == EMPTY)
+            return false;
+    }
+}
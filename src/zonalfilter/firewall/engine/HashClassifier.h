@@ -0,0 +1,52 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_HASHCLASSIFIER_H_
+#define __ZONALFILTER_HASHCLASSIFIER_H_
+
+#include "zonalfilter/firewall/engine/FirewallClassifier.h"
+
+/**
+ * Exact match on (key, type) in an open addressing hash table with linear
+ * probing. Type ranges are expanded into one entry per type, so lookups
+ * are O(1) but memory grows with the total width of the ranges.
+ */
+class HashClassifier : public FirewallClassifier
+{
+  protected:
+    static constexpr uint64_t EMPTY = UINT64_MAX;
+
+    std::vector<uint64_t> table;
+    uint64_t mask = 0;
+    int shift = 64;
+
+  protected:
+    static uint64_t makeEntry(uint32_t key, uint32_t type) { return ((uint64_t)key << 32) | type; }
+    size_t getSlot(uint64_t entry) const { return (entry * 0x9e3779b97f4a7c15ull) >> shift; }
+    void insert(uint64_t entry);
+
+  public:
+    /**
+     * Maximum number of entries after range expansion.
+     */
+    static constexpr size_t MAX_ENTRIES = 1 << 28;
+
+    virtual const char *getName() const override { return "hash"; }
+    virtual void build(const std::vector<Rule>& rules, uint32_t numKeys, uint32_t typeLimit) override;
+    virtual bool matches(uint32_t key, uint32_t type) const override;
+    virtual size_t getMemoryUsage() const override { return table.capacity() * sizeof(uint64_t); }
+};
+
+#endif
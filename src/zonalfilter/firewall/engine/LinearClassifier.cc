@@ -0,0 +1,41 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/firewall/engine/LinearClassifier.h"
+
+void LinearClassifier::build(const std::vector<Rule>& rules, uint32_t numKeys, uint32_t /*typeLimit*/)
+{
+    rangesByKey.assign(numKeys, {});
+    for (const auto& rule : rules)
+        rangesByKey[rule.key].push_back({rule.firstType, rule.lastType});
+}
+
+bool LinearClassifier::matches(uint32_t key, uint32_t type) const
+{
+    for (const auto& range : rangesByKey[key]) {
+        if (range.first <= type && type <= range.last) {
+            return true; // Found message type in in/out table.
+        }
+    }
+    return false;
+}
+
+size_t LinearClassifier::getMemoryUsage() const
+{
+    size_t memory = rangesByKey.capacity() * sizeof(std::vector<Range>);
+    for (const auto& ranges : rangesByKey)
+        memory += ranges.capacity() * sizeof(Range);
+    return memory;
+}
@@ -0,0 +1,42 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_LINEARCLASSIFIER_H_
+#define __ZONALFILTER_LINEARCLASSIFIER_H_
+
+#include "zonalfilter/firewall/engine/FirewallClassifier.h"
+
+/**
+ * Scans the rules of the packet's interface and direction one by one, like
+ * the original firewall. O(rules per interface) per lookup.
+ */
+class LinearClassifier : public FirewallClassifier
+{
+  protected:
+    struct Range {
+        uint32_t first;
+        uint32_t last;
+    };
+
+    std::vector<std::vector<Range>> rangesByKey;
+
+  public:
+    virtual const char *getName() const override { return "linear"; }
+    virtual void build(const std::vector<Rule>& rules, uint32_t numKeys, uint32_t typeLimit) override;
+    virtual bool matches(uint32_t key, uint32_t type) const override;
+    virtual size_t getMemoryUsage() const override;
+};
+
+#endif
@@ -0,0 +1,126 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/macsec/MacsecProcessor.h"
+#include "inet/linklayer/ethernet/common/EthernetMacHeader_m.h"
+#include "zonalfilter/firewall/TypeTag_m.h"
+#include "zonalfilter/timing/StageTiming.h"
+#include <algorithm>
+
+Define_Module(MacsecProcessor);
+
+void MacsecProcessor::initialize(int stage)
+{
+    PacketFlowBase::initialize(stage);
+    if (stage == INITSTAGE_LOCAL) {
+        encrypt = par("encrypt").boolValue();
+        secTagLength = B(par("secTagLength").intValue());
+        icvLength = B(par("icvLength").intValue());
+        delay = par("delay");
+        bitrate = par("bitrate").doubleValue();
+        recordStageTiming = par("recordStageTiming").boolValue();
+        if (secTagLength < B(0) || icvLength < B(0))
+            throw cRuntimeError("secTagLength and icvLength must not be negative");
+        if (delay < 0 || bitrate <= 0)
+            throw cRuntimeError("delay must not be negative and bitrate must be positive");
+        auto chunk = makeShared<ByteCountChunk>(secTagLength);
+        chunk->markImmutable();
+        secTag = chunk;
+        chunk = makeShared<ByteCountChunk>(icvLength);
+        chunk->markImmutable();
+        icv = chunk;
+        WATCH(numProtectedFrames);
+        WATCH(numUncontrolledFrames);
+    }
+}
+
+cGate *MacsecProcessor::getRegistrationForwardingGate(cGate *gate)
+{
+    if (gate == outputGate)
+        return inputGate;
+    else if (gate == inputGate)
+        return outputGate;
+    else
+        throw cRuntimeError("Unknown gate");
+}
+
+bool MacsecProcessor::isControlled(const Packet *packet) const
+{
+    bool typed = false;
+    packet->mapAllRegionTags<TypeTag>(b(0), packet->getDataLength(), [&] (b, b, const Ptr<const TypeTag>&) {
+        typed = true;
+    });
+    return typed;
+}
+
+void MacsecProcessor::pushPacket(Packet *packet, cGate *gate)
+{
+    Enter_Method("pushPacket");
+    take(packet);
+    if (!isControlled(packet)) {
+        numUncontrolledFrames++;
+        pushOrSendPacket(packet, outputGate, consumer);
+        return;
+    }
+    // On the receive side this ends the transmission from the last hop.
+    if (recordStageTiming)
+        markTimingStage(packet, TIMING_STAGE_OTHER);
+    // One engine processes the frames in order: a frame waits until the
+    // engine has taken in the frames before it, then leaves the pipeline
+    // after the fixed latency.
+    simtime_t serviceStart = std::max(simTime(), lastServiceEnd);
+    lastServiceEnd = serviceStart + packet->getTotalLength().get() / bitrate;
+    simtime_t outputTime = lastServiceEnd + delay;
+    processPacket(packet);
+    numProtectedFrames++;
+    scheduleAt(outputTime, packet);
+}
+
+void MacsecProcessor::handleMessage(cMessage *message)
+{
+    if (!message->isSelfMessage()) {
+        PacketFlowBase::handleMessage(message);
+        return;
+    }
+    auto packet = check_and_cast<Packet *>(message);
+    if (recordStageTiming)
+        markTimingStage(packet, TIMING_STAGE_CRYPTO);
+    pushOrSendPacket(packet, outputGate, consumer);
+    updateDisplayString();
+}
+
+void MacsecProcessor::processPacket(Packet *packet)
+{
+    // The SecTAG follows the MAC addresses; with the header still on the
+    // packet, take it off and put it back in front of the SecTAG.
+    auto header = dynamicPtrCast<const EthernetMacHeader>(packet->peekAtFront());
+    if (header != nullptr)
+        packet->popAtFront(header->getChunkLength());
+    if (encrypt) {
+        packet->trimFront();
+        packet->insertAtFront(secTag);
+        packet->insertAtBack(icv);
+    }
+    else {
+        if (packet->getDataLength() < secTagLength + icvLength)
+            throw cRuntimeError("Frame %s is shorter than the SecTAG and ICV, is MACsec enabled on both ends of the link?", packet->getName());
+        // Like popAtFront() / popAtBack() without peeking the chunks.
+        packet->setFrontOffset(packet->getFrontOffset() + secTagLength);
+        packet->setBackOffset(packet->getBackOffset() - icvLength);
+        packet->trim();
+    }
+    if (header != nullptr)
+        packet->insertAtFront(header);
+}
@@ -0,0 +1,71 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_MACSECPROCESSOR_H_
+#define __ZONALFILTER_MACSECPROCESSOR_H_
+
+#include "inet/common/IProtocolRegistrationListener.h"
+#include "inet/common/packet/chunk/ByteCountChunk.h"
+#include "inet/queueing/base/PacketFlowBase.h"
+#include <omnetpp.h>
+
+using namespace omnetpp;
+using namespace inet;
+using namespace queueing;
+
+/**
+ * One direction of a hop-by-hop MACsec (IEEE 802.1AE) port. On the transmit
+ * side (encrypt = true) it inserts a SecTAG of secTagLength bytes after the
+ * Ethernet MAC header (or at the front, if the header is added below) and
+ * appends an ICV of icvLength bytes; on the receive side it removes them.
+ * SecTAG and ICV carry no data, so both are single immutable chunks shared
+ * by all frames.
+ *
+ * A single cipher engine processes the frames in the order they arrived:
+ * it is busy for length / bitrate per frame, and every frame leaves the
+ * pipeline delay after the engine has processed it, so frames that arrive
+ * while the engine is busy queue in front of it.
+ * Frames without application data (no TypeTag, e.g. gPTP) use the
+ * uncontrolled port and pass unchanged and undelayed.
+ */
+class MacsecProcessor : public PacketFlowBase, public TransparentProtocolRegistrationListener
+{
+  protected:
+    bool encrypt = false;
+    B secTagLength = B(0);
+    B icvLength = B(0);
+    simtime_t delay;
+    double bitrate = 0;
+    bool recordStageTiming = false;
+    Ptr<const ByteCountChunk> secTag;
+    Ptr<const ByteCountChunk> icv;
+
+    simtime_t lastServiceEnd;
+    long numProtectedFrames = 0;
+    long numUncontrolledFrames = 0;
+
+  protected:
+    virtual void initialize(int stage) override;
+    virtual void handleMessage(cMessage *message) override;
+    virtual void processPacket(Packet *packet) override;
+    virtual bool isControlled(const Packet *packet) const;
+
+    virtual cGate *getRegistrationForwardingGate(cGate *gate) override;
+
+  public:
+    virtual void pushPacket(Packet *packet, cGate *gate) override;
+};
+
+#endif
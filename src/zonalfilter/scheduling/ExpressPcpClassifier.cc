@@ -0,0 +1,45 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/scheduling/ExpressPcpClassifier.h"
+#include "inet/linklayer/common/PcpTag_m.h"
+
+Define_Module(ExpressPcpClassifier);
+
+void ExpressPcpClassifier::initialize(int stage)
+{
+    PacketClassifierBase::initialize(stage);
+    if (stage == INITSTAGE_LOCAL) {
+        auto pcps = check_and_cast<cValueArray *>(par("expressPcps").objectValue());
+        for (int i = 0; i < pcps->size(); i++) {
+            int pcp = pcps->get(i).intValue();
+            if (pcp < 0 || pcp > 7)
+                throw cRuntimeError("Invalid PCP %d in expressPcps", pcp);
+            expressPcps[pcp] = true;
+        }
+        expressOutputIndex = par("expressOutputIndex").intValue();
+        preemptableOutputIndex = 1 - expressOutputIndex;
+    }
+}
+
+int ExpressPcpClassifier::classifyPacket(Packet *packet)
+{
+    int pcp = -1;
+    if (auto pcpReq = packet->findTag<PcpReq>())
+        pcp = pcpReq->getPcp();
+    else if (auto pcpInd = packet->findTag<PcpInd>())
+        pcp = pcpInd->getPcp();
+    return pcp >= 0 && pcp < 8 && expressPcps[pcp] ? expressOutputIndex : preemptableOutputIndex;
+}
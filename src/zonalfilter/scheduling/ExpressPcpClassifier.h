@@ -0,0 +1,43 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_EXPRESSPCPCLASSIFIER_H_
+#define __ZONALFILTER_EXPRESSPCPCLASSIFIER_H_
+
+#include "inet/queueing/base/PacketClassifierBase.h"
+
+using namespace inet;
+using namespace queueing;
+
+/**
+ * Outbound classifier for frame preemption (802.1Qbu/802.3br): sends frames
+ * whose PCP is one of expressPcps to the express MAC, all others to the
+ * preemptable MAC. The PCP is taken from the PcpReq tag set by the stream
+ * encoder, or the PcpInd tag of a forwarded frame; frames without either
+ * are preemptable.
+ */
+class ExpressPcpClassifier : public PacketClassifierBase
+{
+  protected:
+    bool expressPcps[8] = {};
+    int expressOutputIndex = 0;
+    int preemptableOutputIndex = 1;
+
+  protected:
+    virtual void initialize(int stage) override;
+    virtual int classifyPacket(Packet *packet) override;
+};
+
+#endif
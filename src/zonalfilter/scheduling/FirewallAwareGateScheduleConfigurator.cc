@@ -0,0 +1,297 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/scheduling/FirewallAwareGateScheduleConfigurator.h"
+#include <algorithm>
+#include <cmath>
+
+Define_Module(FirewallAwareGateScheduleConfigurator);
+
+static simtime_t modulo(simtime_t time, simtime_t cycle)
+{
+    return time - cycle * (int64_t)std::floor(time / cycle);
+}
+
+void FirewallAwareGateScheduleConfigurator::initialize(int stage)
+{
+    GateScheduleConfiguratorBase::initialize(stage);
+    if (stage == INITSTAGE_LOCAL) {
+        packetOverhead = B(par("packetOverhead").intValue());
+        guardBand = par("guardBand");
+    }
+}
+
+simtime_t FirewallAwareGateScheduleConfigurator::getFirewallDelay(const Input::NetworkNode *networkNode) const
+{
+    auto bridging = networkNode->module->getSubmodule("bridging");
+    auto delayLayer = bridging != nullptr ? bridging->getSubmodule("firewallProcessingDelayLayer") : nullptr;
+    if (delayLayer == nullptr)
+        return 0;
+    // One delayer per direction; a relayed packet passes the ingress and the egress side.
+    simtime_t delay = 0;
+    for (cModule::SubmoduleIterator it(delayLayer); !it.end(); ++it)
+        if ((*it)->hasPar("delay"))
+            delay += (*it)->par("delay").doubleValue();
+    return delay;
+}
+
+simtime_t FirewallAwareGateScheduleConfigurator::getCryptoDelay(cModule *applicationModule, b payloadLength) const
+{
+    auto crypto = applicationModule != nullptr ? applicationModule->getSubmodule("crypto") : nullptr;
+    auto delayer = crypto != nullptr ? crypto->getSubmodule("delayer") : nullptr;
+    if (delayer == nullptr)
+        return 0;
+    // Same model as the PacketDelayers inside CryptoLayer: delay + length / bitrate.
+    simtime_t cryptoDelay = 0;
+    for (cModule::SubmoduleIterator it(delayer); !it.end(); ++it) {
+        if (!(*it)->hasPar("delay"))
+            continue;
+        simtime_t delay = (*it)->par("delay").doubleValue();
+        if ((*it)->hasPar("bitrate")) {
+            double bitrate = (*it)->par("bitrate").doubleValue();
+            if (bitrate > 0 && std::isfinite(bitrate))
+                delay += payloadLength.get() / bitrate;
+        }
+        cryptoDelay = std::max(cryptoDelay, delay);
+    }
+    return cryptoDelay;
+}
+
+cModule *FirewallAwareGateScheduleConfigurator::findSinkApplication(const Input::NetworkNode *networkNode, cModule *applicationModule) const
+{
+    // The sink is the application of the end device listening on the destination port.
+    auto io = applicationModule != nullptr ? applicationModule->getSubmodule("io") : nullptr;
+    if (io == nullptr || !io->hasPar("destPort"))
+        return nullptr;
+    int destPort = io->par("destPort").intValue();
+    for (cModule::SubmoduleIterator it(networkNode->module); !it.end(); ++it) {
+        if (strcmp((*it)->getName(), "app") != 0)
+            continue;
+        auto sinkIo = (*it)->getSubmodule("io");
+        if (sinkIo != nullptr && sinkIo->hasPar("localPort") && sinkIo->par("localPort").intValue() == destPort)
+            return *it;
+    }
+    return nullptr;
+}
+
+simtime_t FirewallAwareGateScheduleConfigurator::getReplayCheckDelay(cModule *applicationModule) const
+{
+    // Only the receiving CryptoLayer checks the freshness value.
+    auto crypto = applicationModule != nullptr ? applicationModule->getSubmodule("crypto") : nullptr;
+    return crypto != nullptr && crypto->hasPar("replayCheckDelay") ? crypto->par("replayCheckDelay").doubleValue() : 0;
+}
+
+b FirewallAwareGateScheduleConfigurator::getCryptoTrailerLength(cModule *applicationModule) const
+{
+    auto crypto = applicationModule != nullptr ? applicationModule->getSubmodule("crypto") : nullptr;
+    auto cryptoAdder = crypto != nullptr ? crypto->getSubmodule("cryptoAdder") : nullptr;
+    return cryptoAdder != nullptr ? B(cryptoAdder->par("trailerLength").intValue() + cryptoAdder->par("freshnessLength").intValue()) : b(0);
+}
+
+// Returns the earliest start time >= readyTime at which a window of the given
+// duration (plus guard band) is free for every packet of the flow in the gate
+// cycle, or -1 if there is none.
+simtime_t FirewallAwareGateScheduleConfigurator::findWindow(const std::vector<Reservation>& reservations, simtime_t readyTime, simtime_t duration, simtime_t packetInterval, int numPackets) const
+{
+    simtime_t length = duration + guardBand;
+    simtime_t start = readyTime;
+    while (start < readyTime + gateCycleDuration) {
+        simtime_t advance = 0;
+        for (int i = 0; i < numPackets && advance == 0; i++) {
+            simtime_t offset = modulo(start + packetInterval * i, gateCycleDuration);
+            // the window may wrap around the end of the cycle
+            simtime_t pieces[2][2] = {{offset, std::min(offset + length, gateCycleDuration)}, {SIMTIME_ZERO, offset + length - gateCycleDuration}};
+            for (int piece = 0; piece < 2 && advance == 0; piece++) {
+                simtime_t pieceStart = pieces[piece][0];
+                simtime_t pieceEnd = pieces[piece][1];
+                if (pieceEnd <= pieceStart)
+                    continue;
+                // reservations are sorted and disjoint: the first one ending after
+                // pieceStart is the only candidate for an overlap
+                auto it = std::upper_bound(reservations.begin(), reservations.end(), pieceStart, [] (simtime_t time, const Reservation& reservation) {
+                    return time < reservation.end;
+                });
+                if (it != reservations.end() && it->start < pieceEnd)
+                    advance = it->end - offset + (piece == 1 ? gateCycleDuration : SIMTIME_ZERO);
+            }
+        }
+        if (advance == 0)
+            return start;
+        start += advance;
+    }
+    return -1;
+}
+
+void FirewallAwareGateScheduleConfigurator::reserveWindow(std::vector<Reservation>& reservations, simtime_t start, simtime_t duration, simtime_t packetInterval, int numPackets, int gateIndex) const
+{
+    // keep the reservations sorted by start time for findWindow()
+    auto insert = [&] (simtime_t reservationStart, simtime_t reservationEnd) {
+        auto it = std::upper_bound(reservations.begin(), reservations.end(), reservationStart, [] (simtime_t time, const Reservation& reservation) {
+            return time < reservation.start;
+        });
+        reservations.insert(it, {reservationStart, reservationEnd, gateIndex});
+    };
+    for (int i = 0; i < numPackets; i++) {
+        simtime_t offset = modulo(start + packetInterval * i, gateCycleDuration);
+        simtime_t end = offset + duration + guardBand;
+        if (end <= gateCycleDuration)
+            insert(offset, end);
+        else {
+            insert(offset, gateCycleDuration);
+            insert(SIMTIME_ZERO, end - gateCycleDuration);
+        }
+    }
+}
+
+void FirewallAwareGateScheduleConfigurator::addSchedules(Output *output, const Input& input, const Reservations& reservations) const
+{
+    static const std::vector<Reservation> noReservations;
+    for (auto port : input.ports) {
+        auto it = reservations.find(port);
+        const auto& portReservations = it != reservations.end() ? it->second : noReservations;
+        for (int gateIndex = 0; gateIndex < port->numGates; gateIndex++) {
+            auto schedule = new Output::Schedule();
+            schedule->port = port;
+            schedule->gateIndex = gateIndex;
+            schedule->cycleStart = 0;
+            schedule->cycleDuration = gateCycleDuration;
+            bool scheduledGate = std::any_of(portReservations.begin(), portReservations.end(), [&] (const Reservation& reservation) {
+                return reservation.gateIndex == gateIndex;
+            });
+            if (scheduledGate) {
+                // open exactly during the windows of this gate (guard band excluded)
+                for (const auto& reservation : portReservations) {
+                    if (reservation.gateIndex != gateIndex)
+                        continue;
+                    Output::Slot slot;
+                    slot.start = reservation.start;
+                    slot.duration = std::max(SIMTIME_ZERO, reservation.end - reservation.start - (reservation.end == gateCycleDuration ? SIMTIME_ZERO : guardBand));
+                    if (slot.duration > 0)
+                        schedule->slots.push_back(slot);
+                }
+            }
+            else {
+                // unscheduled traffic classes share the time left between the windows
+                simtime_t gapStart = 0;
+                for (const auto& reservation : portReservations) {
+                    if (reservation.start > gapStart) {
+                        Output::Slot slot;
+                        slot.start = gapStart;
+                        slot.duration = reservation.start - gapStart;
+                        schedule->slots.push_back(slot);
+                    }
+                    gapStart = std::max(gapStart, reservation.end);
+                }
+                if (gapStart < gateCycleDuration) {
+                    Output::Slot slot;
+                    slot.start = gapStart;
+                    slot.duration = gateCycleDuration - gapStart;
+                    schedule->slots.push_back(slot);
+                }
+            }
+            output->gateSchedules[port].push_back(schedule);
+        }
+    }
+}
+
+GateScheduleConfiguratorBase::Output *FirewallAwareGateScheduleConfigurator::computeGateScheduling(const Input& input) const
+{
+    auto output = new Output();
+    Reservations reservations;
+
+    std::vector<Input::Flow *> flows(input.flows.begin(), input.flows.end());
+    std::stable_sort(flows.begin(), flows.end(), [] (const Input::Flow *f1, const Input::Flow *f2) {
+        if (f1->startApplication->pcp != f2->startApplication->pcp)
+            return f1->startApplication->pcp > f2->startApplication->pcp;
+        return f1->startApplication->maxLatency < f2->startApplication->maxLatency;
+    });
+
+    for (auto flow : flows) {
+        auto application = flow->startApplication;
+        simtime_t packetInterval = application->packetInterval;
+        int numPackets = (int)std::round(gateCycleDuration / packetInterval);
+        if (numPackets < 1 || packetInterval * numPackets != gateCycleDuration)
+            throw cRuntimeError("The packet interval of flow %s must divide the gate cycle duration", flow->name.c_str());
+        if (flow->pathFragments.empty() || flow->pathFragments[0]->outputPorts.empty())
+            continue;
+
+        b frameLength = application->packetLength + getCryptoTrailerLength(application->module) + packetOverhead;
+        simtime_t sendCryptoDelay = getCryptoDelay(application->module, application->packetLength);
+        cModule *sinkApplication = findSinkApplication(flow->endDevice, application->module);
+        simtime_t receiveCryptoDelay = getCryptoDelay(sinkApplication, application->packetLength) + getReplayCheckDelay(sinkApplication);
+        auto transmissionDuration = [&] (const Input::Port *port) {
+            return SimTime(s(frameLength / port->datarate).get());
+        };
+
+        // Applications with several flows (stream redundancy) keep the start
+        // time chosen for their first flow.
+        auto startTimeIt = output->applicationStartTimes.find(application);
+        bool fixedStartTime = startTimeIt != output->applicationStartTimes.end();
+        auto firstPort = flow->pathFragments[0]->outputPorts[0];
+        simtime_t searchStart = fixedStartTime ? startTimeIt->second + sendCryptoDelay : sendCryptoDelay;
+
+        std::vector<std::pair<Input::Port *, simtime_t>> windows;
+        simtime_t startTime = -1;
+        while (searchStart < sendCryptoDelay + gateCycleDuration) {
+            windows.clear();
+            simtime_t firstWindow = findWindow(reservations[firstPort], searchStart, transmissionDuration(firstPort), packetInterval, numPackets);
+            if (firstWindow < 0)
+                break;
+            simtime_t candidateStartTime = fixedStartTime ? startTimeIt->second : firstWindow - sendCryptoDelay;
+
+            // walk the path: a port's window opens no earlier than the packet
+            // has arrived and passed the firewall of the switch
+            std::map<Input::NetworkNode *, simtime_t> arrivalTimes;
+            arrivalTimes[application->device] = candidateStartTime + sendCryptoDelay;
+            bool feasible = true;
+            for (auto pathFragment : flow->pathFragments) {
+                for (size_t i = 0; i < pathFragment->outputPorts.size() && feasible; i++) {
+                    auto port = pathFragment->outputPorts[i];
+                    auto node = pathFragment->networkNodes[i];
+                    auto nextNode = pathFragment->networkNodes[i + 1];
+                    simtime_t readyTime = arrivalTimes[node];
+                    if (node != application->device)
+                        readyTime += getFirewallDelay(node);
+                    simtime_t window = port == firstPort && node == application->device ? firstWindow :
+                            findWindow(reservations[port], readyTime, transmissionDuration(port), packetInterval, numPackets);
+                    if (window < 0)
+                        feasible = false;
+                    else {
+                        windows.push_back({port, window});
+                        arrivalTimes[nextNode] = window + transmissionDuration(port) + port->propagationTime;
+                    }
+                }
+            }
+            simtime_t latency = arrivalTimes[flow->endDevice] + receiveCryptoDelay - candidateStartTime;
+            if (feasible && (application->maxLatency < 0 || latency <= application->maxLatency)) {
+                startTime = candidateStartTime;
+                EV_INFO << "Scheduled flow " << flow->name << ", start time = " << startTime << ", worst case latency = " << latency << EV_ENDL;
+                break;
+            }
+            if (fixedStartTime)
+                break;
+            searchStart = firstWindow + transmissionDuration(firstPort);
+        }
+        if (startTime < 0)
+            throw cRuntimeError("Cannot schedule flow %s within its maximum latency", flow->name.c_str());
+
+        for (auto& window : windows)
+            reserveWindow(reservations[window.first], window.second, transmissionDuration(window.first), packetInterval, numPackets, flow->gateIndex);
+        output->applicationStartTimes[application] = modulo(startTime, gateCycleDuration);
+    }
+
+    addSchedules(output, input, reservations);
+    return output;
+}
@@ -0,0 +1,71 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_FIREWALLAWAREGATESCHEDULECONFIGURATOR_H_
+#define __ZONALFILTER_FIREWALLAWAREGATESCHEDULECONFIGURATOR_H_
+
+#include "inet/linklayer/configurator/gatescheduling/base/GateScheduleConfiguratorBase.h"
+
+using namespace inet;
+
+/**
+ * Time-aware shaper (802.1Qbv) schedule synthesis that accounts for the
+ * security mechanisms of this project:
+ *
+ *  - the per-hop processing delay of FirewallBridgingLayer (ingress and
+ *    egress firewallProcessingDelayLayer) in every switch on the path
+ *  - the CryptoLayer delay (delay + length / bitrate) at the sending and
+ *    receiving application, and the crypto trailer added to every frame
+ *
+ * Flows are scheduled greedily in priority order: every packet of the gate
+ * cycle gets an exclusive transmission window on each egress port of its
+ * path, opening no earlier than the packet can actually arrive there.
+ * Windows are looked up in per-port interval lists, so the solver scales
+ * to generated topologies with many flows. Gates without scheduled flows on
+ * a port are open whenever no scheduled window is active.
+ */
+class FirewallAwareGateScheduleConfigurator : public GateScheduleConfiguratorBase
+{
+  protected:
+    struct Reservation {
+        simtime_t start;
+        simtime_t end;
+        int gateIndex;
+    };
+
+    // Reserved windows per egress port, within one gate cycle.
+    typedef std::map<Input::Port *, std::vector<Reservation>> Reservations;
+
+  protected:
+    b packetOverhead = b(-1);
+    simtime_t guardBand;
+
+  protected:
+    virtual void initialize(int stage) override;
+
+    virtual Output *computeGateScheduling(const Input& input) const override;
+
+    virtual simtime_t getFirewallDelay(const Input::NetworkNode *networkNode) const;
+    virtual simtime_t getCryptoDelay(cModule *applicationModule, b payloadLength) const;
+    virtual cModule *findSinkApplication(const Input::NetworkNode *networkNode, cModule *applicationModule) const;
+    virtual simtime_t getReplayCheckDelay(cModule *applicationModule) const;
+    virtual b getCryptoTrailerLength(cModule *applicationModule) const;
+
+    virtual simtime_t findWindow(const std::vector<Reservation>& reservations, simtime_t readyTime, simtime_t duration, simtime_t packetInterval, int numPackets) const;
+    virtual void reserveWindow(std::vector<Reservation>& reservations, simtime_t start, simtime_t duration, simtime_t packetInterval, int numPackets, int gateIndex) const;
+    virtual void addSchedules(Output *output, const Input& input, const Reservations& reservations) const;
+};
+
+#endif
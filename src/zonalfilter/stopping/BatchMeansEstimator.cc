@@ -0,0 +1,149 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/stopping/BatchMeansEstimator.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+BatchMeansEstimator::BatchMeansEstimator(size_t batchSize, const std::vector<double>& quantiles) :
+    batchSize(batchSize), quantiles(quantiles), batchQuantiles(quantiles.size())
+{
+    if (batchSize == 0)
+        throw std::invalid_argument("batch size must be positive");
+    for (double quantile : quantiles)
+        if (!(quantile > 0 && quantile < 1))
+            throw std::invalid_argument("quantiles must be between 0 and 1");
+    batch.reserve(batchSize);
+}
+
+bool BatchMeansEstimator::collect(double value)
+{
+    batch.push_back(value);
+    batchSum += value;
+    numObservations++;
+    if (batch.size() < batchSize)
+        return false;
+    batchMeans.push_back(batchSum / batchSize);
+    for (size_t i = 0; i < quantiles.size(); i++) {
+        // empirical quantile: the smallest value with at least the given
+        // fraction of the batch at or below it
+        size_t rank = (size_t)std::ceil(quantiles[i] * batchSize);
+        auto nth = batch.begin() + (rank > 0 ? rank - 1 : 0);
+        std::nth_element(batch.begin(), nth, batch.end());
+        batchQuantiles[i].push_back(*nth);
+    }
+    batch.clear();
+    batchSum = 0;
+    return true;
+}
+
+BatchMeansEstimator::Interval BatchMeansEstimator::computeInterval(const std::vector<double>& values, double confidenceLevel)
+{
+    Interval interval;
+    size_t n = values.size();
+    if (n == 0) {
+        interval.halfWidth = std::numeric_limits<double>::infinity();
+        return interval;
+    }
+    double sum = 0;
+    for (double value : values)
+        sum += value;
+    interval.estimate = sum / n;
+    if (n < 2) {
+        interval.halfWidth = std::numeric_limits<double>::infinity();
+        return interval;
+    }
+    double squares = 0;
+    for (double value : values)
+        squares += (value - interval.estimate) * (value - interval.estimate);
+    double standardError = std::sqrt(squares / (n - 1) / n);
+    interval.halfWidth = studentTQuantile(0.5 + confidenceLevel / 2, n - 1) * standardError;
+    return interval;
+}
+
+BatchMeansEstimator::Interval BatchMeansEstimator::getMeanInterval(double confidenceLevel) const
+{
+    return computeInterval(batchMeans, confidenceLevel);
+}
+
+BatchMeansEstimator::Interval BatchMeansEstimator::getQuantileInterval(size_t index, double confidenceLevel) const
+{
+    return computeInterval(batchQuantiles.at(index), confidenceLevel);
+}
+
+double BatchMeansEstimator::getBatchMeanCorrelation() const
+{
+    size_t n = batchMeans.size();
+    if (n < 3)
+        return 0;
+    double mean = 0;
+    for (double value : batchMeans)
+        mean += value;
+    mean /= n;
+    double variance = 0;
+    double covariance = 0;
+    for (size_t i = 0; i < n; i++) {
+        variance += (batchMeans[i] - mean) * (batchMeans[i] - mean);
+        if (i > 0)
+            covariance += (batchMeans[i] - mean) * (batchMeans[i - 1] - mean);
+    }
+    return variance > 0 ? covariance / variance : 0;
+}
+
+size_t BatchMeansEstimator::getRequiredBatchSize(const std::vector<double>& quantiles, size_t minBatchSize, size_t minTailObservations)
+{
+    size_t batchSize = minBatchSize;
+    for (double quantile : quantiles) {
+        // round before ceil, so that e.g. 10 / (1 - 0.999) gives 10000
+        double required = std::ceil(std::round(minTailObservations / (1 - quantile) * 1e6) / 1e6);
+        batchSize = std::max(batchSize, (size_t)required);
+    }
+    return batchSize;
+}
+
+double BatchMeansEstimator::studentTQuantile(double probability, double degreesOfFreedom)
+{
+    // Abramowitz and Stegun 26.7.5
+    double z = normalQuantile(probability);
+    double n = degreesOfFreedom;
+    double z2 = z * z;
+    double g1 = (z2 + 1) * z / 4;
+    double g2 = ((5 * z2 + 16) * z2 + 3) * z / 96;
+    double g3 = (((3 * z2 + 19) * z2 + 17) * z2 - 15) * z / 384;
+    double g4 = ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) * z / 92160;
+    return z + g1 / n + g2 / (n * n) + g3 / (n * n * n) + g4 / (n * n * n * n);
+}
+
+double BatchMeansEstimator::normalQuantile(double probability)
+{
+    static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+    static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01 };
+    static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+    static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00 };
+    if (!(probability > 0 && probability < 1))
+        throw std::invalid_argument("probability must be between 0 and 1");
+    const double low = 0.02425;
+    if (probability < low) {
+        double q = std::sqrt(-2 * std::log(probability));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+    if (probability > 1 - low)
+        return -normalQuantile(1 - probability);
+    double q = probability - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
@@ -0,0 +1,107 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_BATCHMEANSESTIMATOR_H_
+#define __ZONALFILTER_BATCHMEANSESTIMATOR_H_
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Batch-means confidence intervals for the mean and for quantiles of a
+ * stream of observations (e.g. end-to-end delays). The observations are
+ * split into consecutive, non-overlapping batches of a fixed size; the mean
+ * and the quantiles of each batch are treated as approximately independent
+ * and normal, and the intervals are Student t intervals over the batches.
+ * Quantiles are estimated by sectioning: the estimate is the average of the
+ * per-batch quantiles, so every batch must hold enough observations beyond
+ * the highest quantile.
+ *
+ * Only the current batch is buffered (allocated once by the constructor),
+ * plus one value per batch and statistic.
+ */
+class BatchMeansEstimator
+{
+  public:
+    struct Interval
+    {
+        double estimate = 0;
+        double halfWidth = 0;
+    };
+
+  protected:
+    size_t batchSize;
+    std::vector<double> quantiles;
+    std::vector<double> batch;
+    double batchSum = 0;
+    size_t numObservations = 0;
+    std::vector<double> batchMeans;
+    std::vector<std::vector<double>> batchQuantiles; // per quantile, one value per batch
+
+  protected:
+    static Interval computeInterval(const std::vector<double>& values, double confidenceLevel);
+
+  public:
+    /**
+     * The quantiles are probabilities in (0, 1), e.g. 0.99 and 0.999.
+     */
+    BatchMeansEstimator(size_t batchSize, const std::vector<double>& quantiles);
+
+    /**
+     * Adds an observation. Returns true if it completed a batch.
+     */
+    bool collect(double value);
+
+    size_t getBatchSize() const { return batchSize; }
+    size_t getNumObservations() const { return numObservations; }
+    size_t getNumBatches() const { return batchMeans.size(); }
+    size_t getNumQuantiles() const { return quantiles.size(); }
+    double getQuantile(size_t index) const { return quantiles[index]; }
+
+    /**
+     * Confidence intervals over the completed batches; the half-width is
+     * infinite with fewer than two batches.
+     */
+    Interval getMeanInterval(double confidenceLevel) const;
+    Interval getQuantileInterval(size_t index, double confidenceLevel) const;
+
+    /**
+     * Lag-1 autocorrelation of the batch means. Values well above zero mean
+     * that the batches are too short to be independent and the intervals
+     * too narrow.
+     */
+    double getBatchMeanCorrelation() const;
+
+    /**
+     * The smallest batch size with at least minTailObservations observations
+     * beyond the given quantile, and at least minBatchSize in total.
+     */
+    static size_t getRequiredBatchSize(const std::vector<double>& quantiles, size_t minBatchSize, size_t minTailObservations);
+
+    /**
+     * Quantile function of the Student t distribution with the given degrees
+     * of freedom (Cornish-Fisher expansion around the normal quantile,
+     * accurate to about 0.1% from 5 degrees of freedom on).
+     */
+    static double studentTQuantile(double probability, double degreesOfFreedom);
+
+    /**
+     * Quantile function of the standard normal distribution (Acklam's
+     * rational approximation, relative error below 1.2e-9).
+     */
+    static double normalQuantile(double probability);
+};
+
+#endif
@@ -0,0 +1,193 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/stopping/SequentialStopController.h"
+#include "inet/common/Simsignals.h"
+#include "inet/common/TimeTag_m.h"
+#include "inet/common/packet/Packet.h"
+
+Define_Module(SequentialStopController);
+
+static const char *SINK_APP_TYPE = "zonalfilter.common.TypedUdpSinkApp";
+
+void SequentialStopController::initialize(int stage)
+{
+    if (stage == INITSTAGE_LOCAL) {
+        warmupPeriod = par("warmupPeriod");
+        minSimTime = par("minSimTime");
+        confidenceLevel = par("confidenceLevel");
+        relativePrecision = par("relativePrecision");
+        absolutePrecision = par("absolutePrecision").doubleValue();
+        minBatches = par("minBatches").intValue();
+        if (!(confidenceLevel > 0 && confidenceLevel < 1))
+            throw cRuntimeError("confidenceLevel must be between 0 and 1");
+        if (minBatches < 2)
+            throw cRuntimeError("minBatches must be at least 2");
+
+        std::vector<double> quantiles;
+        auto quantileArray = check_and_cast<cValueArray *>(par("quantiles").objectValue());
+        for (int i = 0; i < quantileArray->size(); i++) {
+            double quantile = quantileArray->get(i).doubleValue();
+            if (!(quantile > 0 && quantile < 1))
+                throw cRuntimeError("Invalid quantile %g, must be between 0 and 1", quantile);
+            quantiles.push_back(quantile);
+        }
+        size_t batchSize = BatchMeansEstimator::getRequiredBatchSize(quantiles, par("minBatchSize").intValue(), par("minTailObservations").intValue());
+        BatchMeansEstimator estimator(batchSize, quantiles);
+
+        std::vector<std::string> tokens = cStringTokenizer(par("applications").stringValue()).asVector();
+        std::vector<cPatternMatcher> patterns(tokens.size());
+        for (size_t i = 0; i < tokens.size(); i++)
+            patterns[i].setPattern(tokens[i].c_str(), true, true, true);
+        findApplications(getSystemModule(), patterns, estimator);
+        if (streams.empty())
+            throw cRuntimeError("No %s matches applications = \"%s\"", SINK_APP_TYPE, par("applications").stringValue());
+        EV_INFO << "Monitoring the end-to-end delay of " << streams.size() << " applications" << EV_FIELD(batchSize) << EV_ENDL;
+
+        stopTimer = new cMessage("stop");
+        WATCH(numConverged);
+    }
+}
+
+void SequentialStopController::findApplications(cModule *module, std::vector<cPatternMatcher>& patterns, const BatchMeansEstimator& estimator)
+{
+    for (cModule::SubmoduleIterator it(module); !it.end(); ++it) {
+        cModule *submodule = *it;
+        if (!strcmp(submodule->getNedTypeName(), SINK_APP_TYPE)) {
+            // Match relative to the network, e.g. "pcm.app[0]".
+            std::string path = submodule->getFullPath();
+            std::string name = path.substr(path.find('.') + 1);
+            bool matches = false;
+            for (auto& pattern : patterns)
+                matches = matches || pattern.matches(name.c_str());
+            if (matches) {
+                cModule *sink = submodule->getSubmodule("sink");
+                if (sink == nullptr)
+                    throw cRuntimeError("Application '%s' has no sink", path.c_str());
+                streams.emplace(sink, Stream(name, estimator));
+                sink->subscribe(packetPushedSignal, this);
+            }
+        }
+        else
+            findApplications(submodule, patterns, estimator);
+    }
+}
+
+void SequentialStopController::handleMessage(cMessage *message)
+{
+    if (message != stopTimer)
+        throw cRuntimeError("This module does not process messages");
+    // Intervals may widen again with new batches, so check once more.
+    if (numConverged == streams.size()) {
+        EV_INFO << "All end-to-end delay estimates reached the target precision, ending the run" << EV_ENDL;
+        endSimulation();
+    }
+}
+
+void SequentialStopController::receiveSignal(cComponent *source, simsignal_t signal, cObject *object, cObject *details)
+{
+    if (simTime() < warmupPeriod)
+        return;
+    auto it = streams.find(source);
+    auto packet = dynamic_cast<Packet *>(object);
+    if (it == streams.end() || packet == nullptr)
+        return;
+
+    // mean bit lifetime, like the sinks' meanBitLifeTimePerPacket statistic
+    simtime_t now = simTime();
+    double weightedLifetime = 0;
+    double totalLength = 0;
+    packet->mapAllRegionTags<CreationTimeTag>(b(0), packet->getDataLength(), [&] (b, b length, const Ptr<const CreationTimeTag>& tag) {
+        weightedLifetime += (now - tag->getCreationTime()).dbl() * length.get();
+        totalLength += length.get();
+    });
+    if (totalLength == 0)
+        return;
+
+    Stream& stream = it->second;
+    if (!stream.estimator.collect(weightedLifetime / totalLength))
+        return;
+    bool converged = isConverged(stream);
+    if (converged != stream.converged) {
+        stream.converged = converged;
+        stream.convergenceTime = converged ? now : -1;
+        if (converged)
+            numConverged++;
+        else
+            numConverged--;
+        EV_DETAIL << "Delay estimate of " << stream.name << (converged ? " reached" : " lost") << " the target precision"
+                  << EV_FIELD(numConverged) << EV_ENDL;
+    }
+    checkStop();
+}
+
+bool SequentialStopController::isPrecise(const BatchMeansEstimator::Interval& interval) const
+{
+    return interval.halfWidth <= std::max(relativePrecision * std::abs(interval.estimate), absolutePrecision);
+}
+
+bool SequentialStopController::isConverged(const Stream& stream) const
+{
+    const BatchMeansEstimator& estimator = stream.estimator;
+    if (estimator.getNumBatches() < minBatches || !isPrecise(estimator.getMeanInterval(confidenceLevel)))
+        return false;
+    for (size_t i = 0; i < estimator.getNumQuantiles(); i++)
+        if (!isPrecise(estimator.getQuantileInterval(i, confidenceLevel)))
+            return false;
+    return true;
+}
+
+void SequentialStopController::checkStop()
+{
+    // Stopping in the listener would unwind the sink's pushPacket(), so
+    // stop from an own event instead.
+    if (numConverged == streams.size() && !stopTimer->isScheduled())
+        scheduleAt(std::max(simTime(), minSimTime), stopTimer);
+}
+
+void SequentialStopController::finish()
+{
+    for (auto& it : streams) {
+        const Stream& stream = it.second;
+        const BatchMeansEstimator& estimator = stream.estimator;
+        cComponent *application = it.first->getParentModule();
+        opp_string_map secondsUnit = { { "unit", "s" } };
+        auto recordInterval = [&] (const std::string& name, const BatchMeansEstimator::Interval& interval) {
+            getEnvir()->recordScalar(application, ("sequentialDelay:" + name).c_str(), interval.estimate, &secondsUnit);
+            getEnvir()->recordScalar(application, ("sequentialDelay:" + name + "HalfWidth").c_str(), interval.halfWidth, &secondsUnit);
+        };
+        recordInterval("mean", estimator.getMeanInterval(confidenceLevel));
+        for (size_t i = 0; i < estimator.getNumQuantiles(); i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "p%g", estimator.getQuantile(i) * 100);
+            recordInterval(name, estimator.getQuantileInterval(i, confidenceLevel));
+        }
+        getEnvir()->recordScalar(application, "sequentialDelay:numObservations", estimator.getNumObservations());
+        getEnvir()->recordScalar(application, "sequentialDelay:numBatches", estimator.getNumBatches());
+        getEnvir()->recordScalar(application, "sequentialDelay:batchMeanCorrelation", estimator.getBatchMeanCorrelation());
+        getEnvir()->recordScalar(application, "sequentialDelay:converged", stream.converged);
+        if (stream.converged)
+            getEnvir()->recordScalar(application, "sequentialDelay:convergenceTime", stream.convergenceTime.dbl(), &secondsUnit);
+        else
+            EV_WARN << "The delay estimate of " << stream.name << " did not reach the target precision"
+                    << EV_FIELD(numBatches, estimator.getNumBatches()) << EV_FIELD(batchSize, estimator.getBatchSize()) << EV_ENDL;
+        if (estimator.getBatchMeanCorrelation() > 0.5)
+            EV_WARN << "The batch means of " << stream.name << " are correlated, consider a larger minBatchSize"
+                    << EV_FIELD(batchMeanCorrelation, estimator.getBatchMeanCorrelation()) << EV_ENDL;
+    }
+    recordScalar("numConverged", numConverged);
+    recordScalar("converged", numConverged == streams.size());
+    recordScalar("stopTime", simTime());
+}
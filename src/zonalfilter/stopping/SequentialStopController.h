@@ -0,0 +1,80 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_SEQUENTIALSTOPCONTROLLER_H_
+#define __ZONALFILTER_SEQUENTIALSTOPCONTROLLER_H_
+
+#include "inet/common/INETDefs.h"
+#include "zonalfilter/stopping/BatchMeansEstimator.h"
+#include <omnetpp.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace omnetpp;
+using namespace inet;
+
+/**
+ * Sequential stopping rule for the end-to-end delays of selected
+ * TypedUdpSinkApps. Subscribes to the packetPushed signal of each selected
+ * application's sink, feeds the delays (mean bit lifetime, as in the sinks'
+ * meanBitLifeTimePerPacket statistic) into a BatchMeansEstimator per
+ * application, and ends the simulation once the confidence intervals of
+ * the mean and of every quantile are narrower than the target precision for
+ * all applications. The run's sim-time-limit is the upper bound if they do
+ * not converge.
+ */
+class SequentialStopController : public cSimpleModule, public cListener
+{
+  protected:
+    struct Stream
+    {
+        std::string name;
+        BatchMeansEstimator estimator;
+        bool converged = false;
+        simtime_t convergenceTime = -1;
+
+        Stream(const std::string& name, const BatchMeansEstimator& estimator) : name(name), estimator(estimator) {}
+    };
+
+    simtime_t warmupPeriod;
+    simtime_t minSimTime;
+    double confidenceLevel = 0;
+    double relativePrecision = 0;
+    double absolutePrecision = 0;
+    size_t minBatches = 0;
+
+    std::map<const cComponent *, Stream> streams; // by sink module
+    size_t numConverged = 0;
+    cMessage *stopTimer = nullptr;
+
+  protected:
+    virtual int numInitStages() const override { return NUM_INIT_STAGES; }
+    virtual void initialize(int stage) override;
+    virtual void handleMessage(cMessage *message) override;
+    virtual void finish() override;
+    virtual void findApplications(cModule *module, std::vector<cPatternMatcher>& patterns, const BatchMeansEstimator& estimator);
+
+    virtual bool isPrecise(const BatchMeansEstimator::Interval& interval) const;
+    virtual bool isConverged(const Stream& stream) const;
+    virtual void checkStop();
+
+  public:
+    virtual ~SequentialStopController() { cancelAndDelete(stopTimer); }
+
+    virtual void receiveSignal(cComponent *source, simsignal_t signal, cObject *object, cObject *details) override;
+};
+
+#endif
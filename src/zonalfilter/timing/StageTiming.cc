@@ -0,0 +1,68 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/timing/StageTiming.h"
+#include "zonalfilter/firewall/TypeTag_m.h"
+
+static bool updateStageTimingTags(Packet *packet, TimingStage stage, bool dequeued)
+{
+    simtime_t now = simTime();
+    bool found = false;
+    // Fragments of an IP datagram carry separate copies of the tag.
+    packet->mapAllRegionTagsForUpdate<StageTimingTag>(b(0), packet->getDataLength(), [&] (b, b, const Ptr<StageTimingTag>& tag) {
+        int index = tag->getInTransmission() ? TIMING_STAGE_TRANSMISSION : stage;
+        tag->setStageTime(index, tag->getStageTime(index) + now - tag->getLastTimestamp());
+        tag->setLastTimestamp(now);
+        tag->setInTransmission(dequeued);
+        if (dequeued)
+            tag->setNumHops(tag->getNumHops() + 1);
+        found = true;
+    });
+    return found;
+}
+
+static void markStage(Packet *packet, TimingStage stage, bool dequeued)
+{
+    if (updateStageTimingTags(packet, stage, dequeued))
+        return;
+    bool typed = false;
+    packet->mapAllRegionTags<TypeTag>(b(0), packet->getDataLength(), [&] (b, b, const Ptr<const TypeTag>&) {
+        typed = true;
+    });
+    if (!typed)
+        return;
+    packet->addRegionTag<StageTimingTag>(b(0), packet->getDataLength())->setLastTimestamp(packet->getCreationTime());
+    updateStageTimingTags(packet, stage, dequeued);
+}
+
+void markTimingStage(Packet *packet, TimingStage stage)
+{
+    markStage(packet, stage, false);
+}
+
+void markTimingDequeued(Packet *packet)
+{
+    markStage(packet, TIMING_STAGE_QUEUEING, true);
+}
+
+const StageTimingTag *findStageTimingTag(const Packet *packet)
+{
+    const StageTimingTag *lastTag = nullptr;
+    packet->mapAllRegionTags<StageTimingTag>(b(0), packet->getDataLength(), [&] (b, b, const Ptr<const StageTimingTag>& tag) {
+        if (lastTag == nullptr || tag->getLastTimestamp() > lastTag->getLastTimestamp())
+            lastTag = tag.get();
+    });
+    return lastTag;
+}
@@ -0,0 +1,45 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_STAGETIMING_H_
+#define __ZONALFILTER_STAGETIMING_H_
+
+#include "inet/common/packet/Packet.h"
+#include "zonalfilter/timing/StageTimingTag_m.h"
+
+using namespace inet;
+
+/**
+ * Ends the current stage of an application packet's StageTimingTag: the
+ * time since the previous mark is added to the given stage, or to
+ * TIMING_STAGE_TRANSMISSION if the packet was dequeued from a MAC queue
+ * since then. The tag is added at the first mark, counting from the
+ * packet's creation; packets without a TypeTag (e.g. gPTP) are ignored.
+ */
+void markTimingStage(Packet *packet, TimingStage stage);
+
+/**
+ * Marks the dequeuing of the packet from a MAC queue: ends the queueing
+ * stage and starts the transmission.
+ */
+void markTimingDequeued(Packet *packet);
+
+/**
+ * Returns the tag of the fragment that arrived last, or nullptr if the
+ * packet has no StageTimingTag.
+ */
+const StageTimingTag *findStageTimingTag(const Packet *packet);
+
+#endif
@@ -0,0 +1,74 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/timing/StageTimingMonitor.h"
+#include "zonalfilter/timing/StageTiming.h"
+#include "inet/common/Simsignals.h"
+
+Define_Module(StageTimingMonitor);
+
+static bool endsWith(const char *text, const char *suffix)
+{
+    size_t textLength = strlen(text);
+    size_t suffixLength = strlen(suffix);
+    return textLength >= suffixLength && strcmp(text + textLength - suffixLength, suffix) == 0;
+}
+
+void StageTimingMonitor::initialize(int stage)
+{
+    if (stage == INITSTAGE_LOCAL) {
+        findQueues(getSystemModule());
+        EV_INFO << "Monitoring " << queues.size() << " MAC queues" << EV_ENDL;
+    }
+}
+
+void StageTimingMonitor::handleMessage(cMessage *message)
+{
+    throw cRuntimeError("This module does not process messages");
+}
+
+void StageTimingMonitor::findQueues(cModule *module)
+{
+    for (cModule::SubmoduleIterator it(module); !it.end(); ++it) {
+        cModule *submodule = *it;
+        // The queue of a MAC layer (macLayer, or expressMacLayer and
+        // preemptableMacLayer with frame preemption), or of an interface
+        // without a separate MAC layer module (eth[*].queue).
+        if (!strcmp(submodule->getName(), "queue") &&
+                (endsWith(module->getName(), "MacLayer") || endsWith(module->getName(), "macLayer") || !strcmp(module->getName(), "eth")))
+        {
+            queues.insert(submodule);
+            submodule->subscribe(packetPushedSignal, this);
+            submodule->subscribe(packetPulledSignal, this);
+        }
+        else
+            findQueues(submodule);
+    }
+}
+
+void StageTimingMonitor::receiveSignal(cComponent *source, simsignal_t signal, cObject *object, cObject *details)
+{
+    // Signals of the queues inside a compound queue (e.g. the per traffic
+    // class queues of a time-aware shaper) reach this listener as well.
+    if (queues.find(source) == queues.end())
+        return;
+    auto packet = dynamic_cast<Packet *>(object);
+    if (packet == nullptr)
+        return;
+    if (signal == packetPushedSignal)
+        markTimingStage(packet, TIMING_STAGE_OTHER);
+    else if (signal == packetPulledSignal)
+        markTimingDequeued(packet);
+}
@@ -0,0 +1,48 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_STAGETIMINGMONITOR_H_
+#define __ZONALFILTER_STAGETIMINGMONITOR_H_
+
+#include "inet/common/INETDefs.h"
+#include <omnetpp.h>
+#include <unordered_set>
+
+using namespace omnetpp;
+using namespace inet;
+
+/**
+ * Marks the MAC queue stages of StageTimingTags. INET's MAC queues cannot
+ * mark packets themselves, so this module subscribes to the packetPushed
+ * and packetPulled signals of every MAC queue in the network: the time
+ * until a packet is pushed is protocol stack time (or transmission time on
+ * the previous hop), the time until it is pulled is queueing time.
+ */
+class StageTimingMonitor : public cSimpleModule, public cListener
+{
+  protected:
+    std::unordered_set<const cComponent *> queues;
+
+  protected:
+    virtual int numInitStages() const override { return NUM_INIT_STAGES; }
+    virtual void initialize(int stage) override;
+    virtual void handleMessage(cMessage *message) override;
+    virtual void findQueues(cModule *module);
+
+  public:
+    virtual void receiveSignal(cComponent *source, simsignal_t signal, cObject *object, cObject *details) override;
+};
+
+#endif
@@ -0,0 +1,62 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/timing/StageTimingRecorder.h"
+#include "zonalfilter/timing/StageTiming.h"
+
+Define_Module(StageTimingRecorder);
+
+simsignal_t StageTimingRecorder::stageTimeSignals[5] = {
+    registerSignal("cryptoTime"),
+    registerSignal("firewallTime"),
+    registerSignal("queueingTime"),
+    registerSignal("transmissionTime"),
+    registerSignal("otherTime"),
+};
+simsignal_t StageTimingRecorder::endToEndDelaySignal = registerSignal("stagedEndToEndDelay");
+simsignal_t StageTimingRecorder::numHopsSignal = registerSignal("numHops");
+
+void StageTimingRecorder::initialize(int stage)
+{
+    PacketFlowBase::initialize(stage);
+    if (stage == INITSTAGE_LOCAL) {
+        auto application = getParentModule();
+        lastStage = application->getSubmodule("crypto") != nullptr ? TIMING_STAGE_CRYPTO : TIMING_STAGE_OTHER;
+        WATCH(numUntimedPackets);
+    }
+}
+
+void StageTimingRecorder::processPacket(Packet *packet)
+{
+    markTimingStage(packet, lastStage);
+    auto tag = findStageTimingTag(packet);
+    if (tag == nullptr) {
+        numUntimedPackets++;
+        return;
+    }
+    simtime_t endToEndDelay = 0;
+    for (int i = 0; i < 5; i++) {
+        emit(stageTimeSignals[i], tag->getStageTime(i));
+        endToEndDelay += tag->getStageTime(i);
+    }
+    emit(endToEndDelaySignal, endToEndDelay);
+    emit(numHopsSignal, tag->getNumHops());
+}
+
+void StageTimingRecorder::finish()
+{
+    if (numUntimedPackets > 0)
+        EV_WARN << numUntimedPackets << " packets had no StageTimingTag, is recordStageTiming set for their stages?" << EV_ENDL;
+}
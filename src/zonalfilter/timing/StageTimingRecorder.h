@@ -0,0 +1,49 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_STAGETIMINGRECORDER_H_
+#define __ZONALFILTER_STAGETIMINGRECORDER_H_
+
+#include "inet/queueing/base/PacketFlowBase.h"
+#include "zonalfilter/timing/StageTimingTag_m.h"
+#include <omnetpp.h>
+
+using namespace omnetpp;
+using namespace inet;
+using namespace queueing;
+
+/**
+ * Records the per-stage delay decomposition (StageTimingTag) of the packets
+ * received by a sink application, as one statistic per stage. The last
+ * stage, from the previous mark to this module, is the receiver's crypto
+ * processing if the application has a crypto layer.
+ */
+class StageTimingRecorder : public PacketFlowBase
+{
+  protected:
+    static simsignal_t stageTimeSignals[5];
+    static simsignal_t endToEndDelaySignal;
+    static simsignal_t numHopsSignal;
+
+    TimingStage lastStage = TIMING_STAGE_OTHER;
+    long numUntimedPackets = 0;
+
+  protected:
+    virtual void initialize(int stage) override;
+    virtual void processPacket(Packet *packet) override;
+    virtual void finish() override;
+};
+
+#endif
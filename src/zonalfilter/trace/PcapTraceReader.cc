@@ -0,0 +1,274 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/trace/PcapTraceReader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+namespace {
+
+const uint32_t PCAP_MAGIC_MICROSECONDS = 0xa1b2c3d4;
+const uint32_t PCAP_MAGIC_NANOSECONDS = 0xa1b23c4d;
+const uint32_t PCAP_FILE_HEADER_LENGTH = 24;
+const uint32_t PCAP_RECORD_HEADER_LENGTH = 16;
+
+const uint32_t PCAPNG_SECTION_HEADER_BLOCK = 0x0a0d0d0a;
+const uint32_t PCAPNG_INTERFACE_DESCRIPTION_BLOCK = 1;
+const uint32_t PCAPNG_OBSOLETE_PACKET_BLOCK = 2;
+const uint32_t PCAPNG_ENHANCED_PACKET_BLOCK = 6;
+const uint32_t PCAPNG_BYTE_ORDER_MAGIC = 0x1a2b3c4d;
+const uint16_t PCAPNG_OPTION_END = 0;
+const uint16_t PCAPNG_OPTION_IF_TSRESOL = 9;
+
+uint32_t swap32(uint32_t value) { return __builtin_bswap32(value); }
+
+} // namespace
+
+PcapTraceReader::PcapTraceReader(const char *fileName, size_t windowSize) :
+    fileName(fileName)
+{
+    fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+        throw cRuntimeError("Cannot open trace file '%s': %s", fileName, strerror(errno));
+    struct stat status;
+    if (fstat(fd, &status) < 0) {
+        close(fd);
+        throw cRuntimeError("Cannot stat trace file '%s': %s", fileName, strerror(errno));
+    }
+    fileSize = status.st_size;
+    pageSize = sysconf(_SC_PAGESIZE);
+    // The window must hold at least one maximum size record.
+    this->windowSize = std::max<size_t>(windowSize, 1 << 20);
+    readFileHeader();
+}
+
+PcapTraceReader::~PcapTraceReader()
+{
+    unmap();
+    if (fd >= 0)
+        close(fd);
+}
+
+const uint8_t *PcapTraceReader::map(uint64_t offset, size_t length)
+{
+    if (offset + length > fileSize)
+        return nullptr;
+    if (window != nullptr && offset >= windowOffset && offset + length <= windowOffset + windowLength)
+        return window + (offset - windowOffset);
+    unmap();
+    windowOffset = offset - offset % pageSize;
+    windowLength = std::min<uint64_t>(std::max<uint64_t>(windowSize, offset + length - windowOffset), fileSize - windowOffset);
+    void *address = mmap(nullptr, windowLength, PROT_READ, MAP_SHARED, fd, windowOffset);
+    if (address == MAP_FAILED) {
+        window = nullptr;
+        throw cRuntimeError("Cannot map trace file '%s' at offset %llu: %s", fileName.c_str(), (unsigned long long)windowOffset, strerror(errno));
+    }
+    madvise(address, windowLength, MADV_SEQUENTIAL);
+    window = static_cast<const uint8_t *>(address);
+    return window + (offset - windowOffset);
+}
+
+void PcapTraceReader::unmap()
+{
+    if (window != nullptr) {
+        munmap(const_cast<uint8_t *>(window), windowLength);
+        window = nullptr;
+    }
+}
+
+uint16_t PcapTraceReader::read16(const uint8_t *p) const
+{
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return swapped ? __builtin_bswap16(value) : value;
+}
+
+uint32_t PcapTraceReader::read32(const uint8_t *p) const
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return swapped ? swap32(value) : value;
+}
+
+void PcapTraceReader::readFileHeader()
+{
+    const uint8_t *header = map(0, sizeof(uint32_t));
+    if (header == nullptr)
+        throw cRuntimeError("Trace file '%s' is empty", fileName.c_str());
+    uint32_t magic;
+    memcpy(&magic, header, sizeof(magic));
+    if (magic == PCAPNG_SECTION_HEADER_BLOCK) {
+        isPcapng = true;
+        position = 0; // the section header block is read like any other block
+        return;
+    }
+    if (magic == PCAP_MAGIC_MICROSECONDS || magic == PCAP_MAGIC_NANOSECONDS)
+        swapped = false;
+    else if (swap32(magic) == PCAP_MAGIC_MICROSECONDS || swap32(magic) == PCAP_MAGIC_NANOSECONDS)
+        swapped = true;
+    else
+        throw cRuntimeError("Trace file '%s' is neither pcap nor pcapng (magic 0x%08x)", fileName.c_str(), magic);
+    nanosecondTimestamps = (swapped ? swap32(magic) : magic) == PCAP_MAGIC_NANOSECONDS;
+    header = map(0, PCAP_FILE_HEADER_LENGTH);
+    if (header == nullptr)
+        throw cRuntimeError("Trace file '%s' has a truncated pcap header", fileName.c_str());
+    // The upper bits of the link type field carry the FCS length.
+    pcapLinkType = read32(header + 20) & 0x0fffffff;
+    position = PCAP_FILE_HEADER_LENGTH;
+}
+
+bool PcapTraceReader::next(Record& record)
+{
+    return isPcapng ? nextPcapngRecord(record) : nextPcapRecord(record);
+}
+
+void PcapTraceReader::rewind()
+{
+    interfaces.clear();
+    readFileHeader();
+}
+
+bool PcapTraceReader::nextPcapRecord(Record& record)
+{
+    const uint8_t *header = map(position, PCAP_RECORD_HEADER_LENGTH);
+    if (header == nullptr)
+        return false;
+    uint32_t seconds = read32(header);
+    uint32_t fraction = read32(header + 4);
+    record.capturedLength = read32(header + 8);
+    record.originalLength = read32(header + 12);
+    // A capture cut off in the middle of a record ends the trace.
+    record.data = map(position + PCAP_RECORD_HEADER_LENGTH, record.capturedLength);
+    if (record.data == nullptr)
+        return false;
+    record.timestamp = (int64_t)seconds * 1000000000 + (nanosecondTimestamps ? fraction : (int64_t)fraction * 1000);
+    record.linkType = pcapLinkType;
+    position += PCAP_RECORD_HEADER_LENGTH + record.capturedLength;
+    return true;
+}
+
+bool PcapTraceReader::nextPcapngRecord(Record& record)
+{
+    while (true) {
+        const uint8_t *header = map(position, 12);
+        if (header == nullptr)
+            return false;
+        uint32_t blockType;
+        memcpy(&blockType, header, sizeof(blockType));
+        if (blockType == PCAPNG_SECTION_HEADER_BLOCK) {
+            // The byte order of a section is only known from its header.
+            uint32_t byteOrderMagic;
+            memcpy(&byteOrderMagic, header + 8, sizeof(byteOrderMagic));
+            if (byteOrderMagic == PCAPNG_BYTE_ORDER_MAGIC)
+                swapped = false;
+            else if (swap32(byteOrderMagic) == PCAPNG_BYTE_ORDER_MAGIC)
+                swapped = true;
+            else
+                throw cRuntimeError("Trace file '%s' has an invalid pcapng section header at offset %llu", fileName.c_str(), (unsigned long long)position);
+        }
+        else
+            blockType = read32(header);
+        uint32_t blockLength = read32(header + 4);
+        if (blockLength < 12 || blockLength % 4 != 0)
+            throw cRuntimeError("Trace file '%s' has an invalid pcapng block length %u at offset %llu", fileName.c_str(), blockLength, (unsigned long long)position);
+        const uint8_t *block = map(position, blockLength);
+        if (block == nullptr)
+            return false;
+        position += blockLength;
+
+        switch (blockType) {
+            case PCAPNG_SECTION_HEADER_BLOCK:
+                readSectionHeader(block, blockLength);
+                break;
+            case PCAPNG_INTERFACE_DESCRIPTION_BLOCK:
+                readInterfaceDescription(block, blockLength);
+                break;
+            case PCAPNG_ENHANCED_PACKET_BLOCK:
+            case PCAPNG_OBSOLETE_PACKET_BLOCK: {
+                if (blockLength < 32)
+                    throw cRuntimeError("Trace file '%s' has a truncated packet block", fileName.c_str());
+                uint32_t interfaceId = blockType == PCAPNG_ENHANCED_PACKET_BLOCK ? read32(block + 8) : read16(block + 8);
+                if (interfaceId >= interfaces.size())
+                    throw cRuntimeError("Trace file '%s' refers to undefined interface %u", fileName.c_str(), interfaceId);
+                const Interface& interface = interfaces[interfaceId];
+                uint64_t timestamp = ((uint64_t)read32(block + 12) << 32) | read32(block + 16);
+                record.timestamp = toNanoseconds(timestamp, interface);
+                record.linkType = interface.linkType;
+                record.capturedLength = std::min(read32(block + 20), blockLength - 32);
+                record.originalLength = read32(block + 24);
+                record.data = block + 28;
+                return true;
+            }
+            default:
+                // Simple packet blocks carry no timestamp and cannot be
+                // replayed; statistics, name resolution etc. are irrelevant.
+                break;
+        }
+    }
+}
+
+void PcapTraceReader::readSectionHeader(const uint8_t *block, uint32_t blockLength)
+{
+    if (blockLength < 28)
+        throw cRuntimeError("Trace file '%s' has a truncated pcapng section header", fileName.c_str());
+    uint16_t majorVersion = read16(block + 12);
+    if (majorVersion != 1)
+        throw cRuntimeError("Trace file '%s' has unsupported pcapng version %u", fileName.c_str(), majorVersion);
+    interfaces.clear(); // interface IDs are local to the section
+}
+
+void PcapTraceReader::readInterfaceDescription(const uint8_t *block, uint32_t blockLength)
+{
+    if (blockLength < 20)
+        throw cRuntimeError("Trace file '%s' has a truncated pcapng interface description", fileName.c_str());
+    Interface interface;
+    interface.linkType = read16(block + 8);
+    const uint8_t *option = block + 16;
+    const uint8_t *end = block + blockLength - 4;
+    while (option + 4 <= end) {
+        uint16_t code = read16(option);
+        uint16_t length = read16(option + 2);
+        if (code == PCAPNG_OPTION_END || option + 4 + length > end)
+            break;
+        if (code == PCAPNG_OPTION_IF_TSRESOL && length >= 1) {
+            interface.decimalResolution = (option[4] & 0x80) == 0;
+            interface.resolutionExponent = option[4] & 0x7f;
+        }
+        option += 4 + ((length + 3) & ~3);
+    }
+    interfaces.push_back(interface);
+}
+
+int64_t PcapTraceReader::toNanoseconds(uint64_t timestamp, const Interface& interface) const
+{
+    if (!interface.decimalResolution)
+        return (int64_t)(((unsigned __int128)timestamp * 1000000000) >> interface.resolutionExponent);
+    int exponent = interface.resolutionExponent;
+    for (; exponent < 9; exponent++)
+        timestamp *= 10;
+    for (; exponent > 9; exponent--)
+        timestamp /= 10;
+    return timestamp;
+}
@@ -0,0 +1,103 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_PCAPTRACEREADER_H_
+#define __ZONALFILTER_PCAPTRACEREADER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Streams the packet records of a pcap or pcapng file.
+ *
+ * The file is memory-mapped through a sliding window of windowSize bytes
+ * instead of being read into memory, so traces of any size can be replayed
+ * with a bounded footprint. Both byte orders, microsecond and nanosecond
+ * pcap timestamps, and pcapng files with several sections and interfaces
+ * (each with its own link type and timestamp resolution) are supported.
+ */
+class PcapTraceReader
+{
+  public:
+    struct Record {
+        int64_t timestamp = 0; // nanoseconds since the epoch
+        uint32_t linkType = 0;
+        uint32_t capturedLength = 0;
+        uint32_t originalLength = 0;
+        const uint8_t *data = nullptr; // valid until the next call to next()
+    };
+
+  protected:
+    struct Interface {
+        uint32_t linkType = 0;
+        bool decimalResolution = true;
+        uint8_t resolutionExponent = 6; // pcapng default: microseconds
+    };
+
+    std::string fileName;
+    int fd = -1;
+    uint64_t fileSize = 0;
+    size_t windowSize = 0;
+    size_t pageSize = 0;
+
+    const uint8_t *window = nullptr;
+    uint64_t windowOffset = 0;
+    size_t windowLength = 0;
+
+    uint64_t position = 0;
+    bool isPcapng = false;
+    bool swapped = false;
+    bool nanosecondTimestamps = false;
+    uint32_t pcapLinkType = 0;
+    std::vector<Interface> interfaces; // of the current pcapng section
+
+  protected:
+    const uint8_t *map(uint64_t offset, size_t length);
+    void unmap();
+
+    uint16_t read16(const uint8_t *p) const;
+    uint32_t read32(const uint8_t *p) const;
+
+    void readFileHeader();
+    bool nextPcapRecord(Record& record);
+    bool nextPcapngRecord(Record& record);
+    void readSectionHeader(const uint8_t *block, uint32_t blockLength);
+    void readInterfaceDescription(const uint8_t *block, uint32_t blockLength);
+    int64_t toNanoseconds(uint64_t timestamp, const Interface& interface) const;
+
+  public:
+    PcapTraceReader(const char *fileName, size_t windowSize);
+    ~PcapTraceReader();
+
+    PcapTraceReader(const PcapTraceReader&) = delete;
+    PcapTraceReader& operator=(const PcapTraceReader&) = delete;
+
+    const std::string& getFileName() const { return fileName; }
+    uint64_t getFileSize() const { return fileSize; }
+
+    /**
+     * Reads the next packet record. Returns false at the end of the file.
+     */
+    bool next(Record& record);
+
+    /**
+     * Restarts reading at the first record.
+     */
+    void rewind();
+};
+
+#endif
@@ -0,0 +1,165 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/trace/PcapTraceSource.h"
+
+#include <algorithm>
+
+#include "inet/common/TimeTag_m.h"
+#include "inet/common/packet/chunk/ByteCountChunk.h"
+#include "zonalfilter/firewall/TypeTag_m.h"
+#include "zonalfilter/firewall/TypeTagger.h"
+
+Define_Module(PcapTraceSource);
+
+void PcapTraceSource::initialize(int stage)
+{
+    ClockUserModuleMixin::initialize(stage);
+    if (stage == INITSTAGE_LOCAL) {
+        startTime = SIMTIME_AS_CLOCKTIME(par("startTime").doubleValue());
+        timeScale = par("timeScale").doubleValue();
+        if (timeScale <= 0)
+            throw cRuntimeError("timeScale must be positive");
+        traceStartOffset = SimTime(par("traceStartOffset").doubleValue()).inUnit(SIMTIME_NS);
+        double traceDuration = par("traceDuration").doubleValue();
+        traceEndOffset = traceDuration < 0 ? -1 : traceStartOffset + SimTime(traceDuration).inUnit(SIMTIME_NS);
+        flowMatch = TraceFlowMatch(check_and_cast<cValueMap *>(par("flow").objectValue()));
+        readClassifier();
+        reader.reset(new PcapTraceReader(par("traceFile").stringValue(), par("mapWindowSize").intValue()));
+        replayTimer = new ClockEvent("ReplayTimer");
+        WATCH(numReplayedPackets);
+        WATCH(numUnclassifiedPackets);
+        WATCH(numUnsupportedPackets);
+    }
+    else if (stage == INITSTAGE_QUEUEING) {
+        if (readNextPacket())
+            scheduleReplayTimer();
+    }
+}
+
+void PcapTraceSource::readClassifier()
+{
+    cValueArray *entries = check_and_cast<cValueArray *>(par("classifier").objectValue());
+    for (int i = 0; i < entries->size(); i++) {
+        cValueMap *entry = check_and_cast<cValueMap *>(entries->get(i).objectValue());
+        if (!entry->containsKey("type"))
+            throw cRuntimeError("Classifier entry %d has no type", i);
+        const char *type = entry->get("type").stringValue();
+        classifier.push_back({TraceFlowMatch(entry, "type"), type, TypeTagger::getTypeId(type)});
+    }
+    if (classifier.empty())
+        throw cRuntimeError("The classifier must have at least one entry");
+}
+
+void PcapTraceSource::handleMessage(cMessage *message)
+{
+    if (message == replayTimer)
+        replayPacket();
+    else
+        throw cRuntimeError("Unknown message");
+}
+
+bool PcapTraceSource::readNextPacket()
+{
+    PcapTraceReader::Record record;
+    TraceFlow flow;
+    while (reader->next(record)) {
+        // Times are relative to the first packet of the trace (of any flow),
+        // so sources replaying different flows of one trace stay aligned.
+        if (firstTimestamp == -1)
+            firstTimestamp = record.timestamp;
+        int64_t offset = record.timestamp - firstTimestamp;
+        if (offset < traceStartOffset)
+            continue;
+        if (traceEndOffset != -1 && offset > traceEndOffset)
+            break;
+        if (!flow.parse(record.linkType, record.data, record.capturedLength, record.originalLength)) {
+            numUnsupportedPackets++;
+            continue;
+        }
+        if (!flowMatch.matches(flow))
+            continue;
+        const ClassifierEntry *entry = nullptr;
+        for (const auto& candidate : classifier) {
+            if (candidate.match.matches(flow)) {
+                entry = &candidate;
+                break;
+            }
+        }
+        if (entry == nullptr) {
+            numUnclassifiedPackets++;
+            continue;
+        }
+        clocktime_t time = startTime + SIMTIME_AS_CLOCKTIME(SimTime(offset - traceStartOffset, SIMTIME_NS) / timeScale);
+        // Merged captures are not always ordered; late packets are sent right away.
+        nextPacketTime = hasNextPacket && time < nextPacketTime ? nextPacketTime : time;
+        // Empty payloads (e.g. bare TCP ACKs) still occupy one byte of data.
+        nextPacketLength = B(std::max<uint32_t>(flow.payloadLength, 1));
+        nextPacketType = entry->type.c_str();
+        nextPacketTypeId = entry->typeId;
+        hasNextPacket = true;
+        return true;
+    }
+    hasNextPacket = false;
+    return false;
+}
+
+void PcapTraceSource::scheduleReplayTimer()
+{
+    scheduleClockEventAt(std::max(nextPacketTime, getClockTime()), replayTimer);
+}
+
+void PcapTraceSource::replayPacket()
+{
+    // Like ActivePacketSource, wait for handleCanPushPacketChanged() if the
+    // consumer is busy; the packet is then sent late rather than dropped.
+    if (consumer != nullptr && !consumer->canPushSomePacket(outputGate->getPathEndGate()))
+        return;
+    auto data = makeShared<ByteCountChunk>(nextPacketLength);
+    data->addTag<CreationTimeTag>()->setCreationTime(simTime());
+    auto packet = new Packet(createPacketName(data), data);
+    auto typeTag = packet->addRegionTag<TypeTag>();
+    typeTag->setType(nextPacketType);
+    typeTag->setTypeId(nextPacketTypeId);
+    numProcessedPackets++;
+    processedTotalLength += packet->getDataLength();
+    numReplayedPackets++;
+    EV_INFO << "Replaying packet" << EV_FIELD(packet) << EV_ENDL;
+    emit(packetPushedSignal, packet);
+    pushOrSendPacket(packet, outputGate, consumer);
+    updateDisplayString();
+    if (readNextPacket())
+        scheduleReplayTimer();
+}
+
+void PcapTraceSource::handleCanPushPacketChanged(cGate *gate)
+{
+    Enter_Method("handleCanPushPacketChanged");
+    if (hasNextPacket && !replayTimer->isScheduled())
+        replayPacket();
+}
+
+void PcapTraceSource::handlePushPacketProcessed(Packet *packet, cGate *gate, bool successful)
+{
+    Enter_Method("handlePushPacketProcessed");
+}
+
+void PcapTraceSource::finish()
+{
+    if (numUnclassifiedPackets > 0)
+        EV_WARN << "Skipped " << numUnclassifiedPackets << " packets of the selected flows that matched no classifier entry" << EV_ENDL;
+    if (numUnsupportedPackets > 0)
+        EV_WARN << "Skipped " << numUnsupportedPackets << " packets with an unsupported link type" << EV_ENDL;
+}
@@ -0,0 +1,87 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_PCAPTRACESOURCE_H_
+#define __ZONALFILTER_PCAPTRACESOURCE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "inet/common/clock/ClockUserModuleMixin.h"
+#include "inet/queueing/base/ActivePacketSourceBase.h"
+#include "zonalfilter/trace/PcapTraceReader.h"
+#include "zonalfilter/trace/TraceFlow.h"
+
+using namespace inet;
+using namespace queueing;
+
+/**
+ * Replays the packets of one or more flows of a recorded pcap/pcapng trace,
+ * at the recorded times and with the recorded payload lengths. The trace is
+ * streamed (see PcapTraceReader) one packet ahead of the replay, so only the
+ * mapped window is kept in memory.
+ *
+ * Each packet is classified by the first matching entry of the classifier
+ * and gets the entry's type as TypeTag.
+ */
+class PcapTraceSource : public ClockUserModuleMixin<ActivePacketSourceBase>
+{
+  protected:
+    struct ClassifierEntry {
+        TraceFlowMatch match;
+        std::string type;
+        int typeId; // see TypeTagger::getTypeId()
+    };
+
+    std::unique_ptr<PcapTraceReader> reader;
+    TraceFlowMatch flowMatch;
+    std::vector<ClassifierEntry> classifier;
+    clocktime_t startTime;
+    double timeScale = 1;
+    int64_t traceStartOffset = 0; // ns
+    int64_t traceEndOffset = -1; // ns, -1 means until the end of the trace
+
+    ClockEvent *replayTimer = nullptr;
+    int64_t firstTimestamp = -1;
+
+    bool hasNextPacket = false;
+    clocktime_t nextPacketTime;
+    B nextPacketLength = B(0);
+    const char *nextPacketType = nullptr;
+    int nextPacketTypeId = -1;
+
+    long numReplayedPackets = 0;
+    long numUnclassifiedPackets = 0;
+    long numUnsupportedPackets = 0;
+
+  protected:
+    virtual void initialize(int stage) override;
+    virtual void handleMessage(cMessage *message) override;
+    virtual void finish() override;
+
+    virtual void readClassifier();
+    virtual bool readNextPacket();
+    virtual void scheduleReplayTimer();
+    virtual void replayPacket();
+
+  public:
+    virtual ~PcapTraceSource() { cancelAndDeleteClockEvent(replayTimer); }
+
+    virtual void handleCanPushPacketChanged(cGate *gate) override;
+    virtual void handlePushPacketProcessed(Packet *packet, cGate *gate, bool successful) override;
+};
+
+#endif
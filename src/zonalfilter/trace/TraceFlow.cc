@@ -0,0 +1,281 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#include "zonalfilter/trace/TraceFlow.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// Link types, see https://www.tcpdump.org/linktypes.html
+const uint32_t LINKTYPE_ETHERNET = 1;
+const uint32_t LINKTYPE_RAW = 101;
+const uint32_t LINKTYPE_LINUX_SLL = 113;
+const uint32_t LINKTYPE_IPV4 = 228;
+const uint32_t LINKTYPE_IPV6 = 229;
+const uint32_t LINKTYPE_LINUX_SLL2 = 276;
+
+const int ETHERTYPE_IPV4 = 0x0800;
+const int ETHERTYPE_IPV6 = 0x86dd;
+const int ETHERTYPE_VLAN = 0x8100;
+const int ETHERTYPE_QINQ = 0x88a8;
+
+const int PROTOCOL_TCP = 6;
+const int PROTOCOL_UDP = 17;
+
+const uint8_t IPV4_MAPPED_PREFIX[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+inline int get16(const uint8_t *p) { return (p[0] << 8) | p[1]; }
+
+inline uint32_t remainder(uint32_t length, uint32_t headerLength) { return length > headerLength ? length - headerLength : 0; }
+
+} // namespace
+
+bool TraceFlow::parse(uint32_t linkType, const uint8_t *data, uint32_t capturedLength, uint32_t originalLength)
+{
+    *this = TraceFlow();
+    uint32_t offset = 0;
+    switch (linkType) {
+        case LINKTYPE_ETHERNET:
+            payloadLength = remainder(originalLength, 14);
+            if (capturedLength < 14)
+                return true;
+            hasMac = true;
+            memcpy(dstMac, data, 6);
+            memcpy(srcMac, data + 6, 6);
+            etherType = get16(data + 12);
+            offset = 14;
+            // The outermost tag determines VLAN and priority.
+            while ((etherType == ETHERTYPE_VLAN || etherType == ETHERTYPE_QINQ) && offset + 4 <= capturedLength) {
+                int tci = get16(data + offset);
+                if (vlan == -1) {
+                    pcp = tci >> 13;
+                    vlan = tci & 0xfff;
+                }
+                etherType = get16(data + offset + 2);
+                offset += 4;
+            }
+            break;
+        case LINKTYPE_LINUX_SLL:
+            offset = 16;
+            if (capturedLength >= offset)
+                etherType = get16(data + 14);
+            break;
+        case LINKTYPE_LINUX_SLL2:
+            offset = 20;
+            if (capturedLength >= offset)
+                etherType = get16(data);
+            break;
+        case LINKTYPE_RAW:
+        case LINKTYPE_IPV4:
+        case LINKTYPE_IPV6:
+            if (capturedLength >= 1)
+                etherType = (data[0] >> 4) == 6 ? ETHERTYPE_IPV6 : ETHERTYPE_IPV4;
+            break;
+        default:
+            return false;
+    }
+    payloadLength = remainder(originalLength, offset);
+
+    uint32_t transportOffset = 0;
+    uint32_t transportLength = 0;
+    if (etherType == ETHERTYPE_IPV4 && offset + 20 <= capturedLength) {
+        const uint8_t *header = data + offset;
+        uint32_t headerLength = (header[0] & 0x0f) * 4;
+        hasAddresses = true;
+        memcpy(srcAddress, IPV4_MAPPED_PREFIX, 12);
+        memcpy(srcAddress + 12, header + 12, 4);
+        memcpy(dstAddress, IPV4_MAPPED_PREFIX, 12);
+        memcpy(dstAddress + 12, header + 16, 4);
+        protocol = header[9];
+        // The IP length excludes Ethernet padding of short frames.
+        payloadLength = remainder(get16(header + 2), headerLength);
+        bool firstFragment = (get16(header + 6) & 0x1fff) == 0;
+        if (firstFragment) {
+            transportOffset = offset + headerLength;
+            transportLength = payloadLength;
+        }
+    }
+    else if (etherType == ETHERTYPE_IPV6 && offset + 40 <= capturedLength) {
+        const uint8_t *header = data + offset;
+        hasAddresses = true;
+        memcpy(srcAddress, header + 8, 16);
+        memcpy(dstAddress, header + 24, 16);
+        payloadLength = get16(header + 4);
+        int nextHeader = header[6];
+        uint32_t extensionOffset = offset + 40;
+        uint32_t extensionLength = 0;
+        bool firstFragment = true;
+        // Skip hop-by-hop, routing, fragment and destination options headers.
+        while ((nextHeader == 0 || nextHeader == 43 || nextHeader == 44 || nextHeader == 60) && extensionOffset + 8 <= capturedLength) {
+            const uint8_t *extension = data + extensionOffset;
+            uint32_t length = nextHeader == 44 ? 8 : (extension[1] + 1) * 8;
+            if (nextHeader == 44)
+                firstFragment = (get16(extension + 2) & 0xfff8) == 0;
+            nextHeader = extension[0];
+            extensionOffset += length;
+            extensionLength += length;
+        }
+        protocol = nextHeader;
+        payloadLength = remainder(payloadLength, extensionLength);
+        if (firstFragment) {
+            transportOffset = extensionOffset;
+            transportLength = payloadLength;
+        }
+    }
+
+    if (transportOffset != 0 && (protocol == PROTOCOL_UDP || protocol == PROTOCOL_TCP) && transportOffset + 4 <= capturedLength) {
+        const uint8_t *header = data + transportOffset;
+        srcPort = get16(header);
+        dstPort = get16(header + 2);
+        if (protocol == PROTOCOL_UDP)
+            payloadLength = remainder(transportLength, 8);
+        else if (transportOffset + 13 <= capturedLength)
+            payloadLength = remainder(transportLength, (header[12] >> 4) * 4);
+    }
+    return true;
+}
+
+TraceFlowMatch::TraceFlowMatch(const cValueMap *conditions, const char *ignoredKey)
+{
+    for (const auto& entry : conditions->getFields()) {
+        const std::string& key = entry.first;
+        const cValue& value = entry.second;
+        if (ignoredKey != nullptr && key == ignoredKey)
+            continue;
+        if (key == "srcMac") {
+            parseMac(value.stringValue(), srcMac);
+            fields |= 1u << SRC_MAC;
+        }
+        else if (key == "dstMac") {
+            parseMac(value.stringValue(), dstMac);
+            fields |= 1u << DST_MAC;
+        }
+        else if (key == "vlan") {
+            vlan = value.intValue();
+            fields |= 1u << VLAN;
+        }
+        else if (key == "pcp") {
+            pcp = value.intValue();
+            fields |= 1u << PCP;
+        }
+        else if (key == "etherType") {
+            etherType = value.intValue();
+            fields |= 1u << ETHER_TYPE;
+        }
+        else if (key == "srcAddress") {
+            parseAddress(value.stringValue(), srcAddress, srcPrefixLength);
+            fields |= 1u << SRC_ADDRESS;
+        }
+        else if (key == "dstAddress") {
+            parseAddress(value.stringValue(), dstAddress, dstPrefixLength);
+            fields |= 1u << DST_ADDRESS;
+        }
+        else if (key == "protocol") {
+            protocol = value.intValue();
+            fields |= 1u << PROTOCOL;
+        }
+        else if (key == "srcPort") {
+            srcPort = value.intValue();
+            fields |= 1u << SRC_PORT;
+        }
+        else if (key == "dstPort") {
+            dstPort = value.intValue();
+            fields |= 1u << DST_PORT;
+        }
+        else
+            throw cRuntimeError("Unknown trace flow field '%s'", key.c_str());
+    }
+}
+
+void TraceFlowMatch::parseMac(const char *text, uint8_t *mac)
+{
+    char separator[5][2];
+    if (sscanf(text, "%2hhx%1[:-]%2hhx%1[:-]%2hhx%1[:-]%2hhx%1[:-]%2hhx%1[:-]%2hhx",
+            &mac[0], separator[0], &mac[1], separator[1], &mac[2], separator[2], &mac[3], separator[3], &mac[4], separator[4], &mac[5]) != 11)
+        throw cRuntimeError("Invalid MAC address '%s'", text);
+}
+
+void TraceFlowMatch::parseAddress(const char *text, uint8_t *address, int& prefixLength)
+{
+    std::string string = text;
+    auto slash = string.find('/');
+    std::string addressPart = string.substr(0, slash);
+    int maxPrefixLength;
+    if (inet_pton(AF_INET, addressPart.c_str(), address + 12) == 1) {
+        memcpy(address, IPV4_MAPPED_PREFIX, 12);
+        maxPrefixLength = 32;
+    }
+    else if (inet_pton(AF_INET6, addressPart.c_str(), address) == 1)
+        maxPrefixLength = 128;
+    else
+        throw cRuntimeError("Invalid IP address '%s'", text);
+    prefixLength = maxPrefixLength;
+    if (slash != std::string::npos) {
+        const char *prefixText = text + slash + 1;
+        char *end;
+        errno = 0;
+        long value = strtol(prefixText, &end, 10);
+        if (*prefixText < '0' || *prefixText > '9' || *end != '\0' || errno != 0 || value > maxPrefixLength)
+            throw cRuntimeError("Invalid prefix length in '%s'", text);
+        prefixLength = value;
+    }
+    // Prefix lengths are kept relative to the 128 bit (mapped) address.
+    prefixLength += 128 - maxPrefixLength;
+}
+
+bool TraceFlowMatch::matchesPrefix(const uint8_t *address, const uint8_t *prefix, int prefixLength)
+{
+    int bytes = prefixLength / 8;
+    if (memcmp(address, prefix, bytes) != 0)
+        return false;
+    int bits = prefixLength % 8;
+    if (bits == 0)
+        return true;
+    uint8_t mask = 0xff << (8 - bits);
+    return (address[bytes] & mask) == (prefix[bytes] & mask);
+}
+
+bool TraceFlowMatch::matches(const TraceFlow& flow) const
+{
+    if (fields == 0)
+        return true;
+    if (has(SRC_MAC) && (!flow.hasMac || memcmp(flow.srcMac, srcMac, 6) != 0))
+        return false;
+    if (has(DST_MAC) && (!flow.hasMac || memcmp(flow.dstMac, dstMac, 6) != 0))
+        return false;
+    if (has(VLAN) && flow.vlan != vlan)
+        return false;
+    if (has(PCP) && flow.pcp != pcp)
+        return false;
+    if (has(ETHER_TYPE) && flow.etherType != etherType)
+        return false;
+    if (has(SRC_ADDRESS) && (!flow.hasAddresses || !matchesPrefix(flow.srcAddress, srcAddress, srcPrefixLength)))
+        return false;
+    if (has(DST_ADDRESS) && (!flow.hasAddresses || !matchesPrefix(flow.dstAddress, dstAddress, dstPrefixLength)))
+        return false;
+    if (has(PROTOCOL) && flow.protocol != protocol)
+        return false;
+    if (has(SRC_PORT) && flow.srcPort != srcPort)
+        return false;
+    if (has(DST_PORT) && flow.dstPort != dstPort)
+        return false;
+    return true;
+}
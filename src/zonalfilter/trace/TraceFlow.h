@@ -0,0 +1,99 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+// 
+
+#ifndef __ZONALFILTER_TRACEFLOW_H_
+#define __ZONALFILTER_TRACEFLOW_H_
+
+#include <cstdint>
+#include <omnetpp.h>
+
+using namespace omnetpp;
+
+/**
+ * Header fields of a recorded packet that identify its flow, decoded from
+ * Ethernet (with 802.1Q/802.1ad tags), Linux cooked (SLL/SLL2) or raw IP
+ * captures. Addresses are kept in network byte order, IPv4 addresses as
+ * IPv4-mapped IPv6 addresses.
+ */
+struct TraceFlow
+{
+    bool hasMac = false;
+    uint8_t srcMac[6] = {};
+    uint8_t dstMac[6] = {};
+    int vlan = -1;
+    int pcp = -1;
+    int etherType = -1;
+
+    bool hasAddresses = false;
+    uint8_t srcAddress[16] = {};
+    uint8_t dstAddress[16] = {};
+    int protocol = -1;
+    int srcPort = -1;
+    int dstPort = -1;
+
+    /**
+     * Length of the application data: the UDP/TCP payload, the IP payload
+     * for other IP protocols, or the frame payload for non-IP frames.
+     */
+    uint32_t payloadLength = 0;
+
+    /**
+     * Decodes a captured packet. Returns false if the link type is not
+     * supported; truncated headers leave the inner fields unset.
+     */
+    bool parse(uint32_t linkType, const uint8_t *data, uint32_t capturedLength, uint32_t originalLength);
+};
+
+/**
+ * A conjunction of flow field conditions, configured from an object
+ * parameter such as {srcAddress: "10.0.1.0/24", protocol: 17, dstPort: 30490}.
+ * Fields: srcMac, dstMac, vlan, pcp, etherType, srcAddress, dstAddress (with
+ * an optional prefix length), protocol, srcPort, dstPort. Unknown fields are
+ * rejected, except ignoredKey (e.g. the "type" of a classifier entry). An
+ * empty map matches every packet.
+ */
+class TraceFlowMatch
+{
+  protected:
+    enum Field { SRC_MAC, DST_MAC, VLAN, PCP, ETHER_TYPE, SRC_ADDRESS, DST_ADDRESS, PROTOCOL, SRC_PORT, DST_PORT, NUM_FIELDS };
+
+    unsigned int fields = 0; // bit set of configured fields
+    uint8_t srcMac[6] = {};
+    uint8_t dstMac[6] = {};
+    int vlan = -1;
+    int pcp = -1;
+    int etherType = -1;
+    uint8_t srcAddress[16] = {};
+    int srcPrefixLength = 0;
+    uint8_t dstAddress[16] = {};
+    int dstPrefixLength = 0;
+    int protocol = -1;
+    int srcPort = -1;
+    int dstPort = -1;
+
+  protected:
+    bool has(Field field) const { return (fields & (1u << field)) != 0; }
+    static void parseMac(const char *text, uint8_t *mac);
+    static void parseAddress(const char *text, uint8_t *address, int& prefixLength);
+    static bool matchesPrefix(const uint8_t *address, const uint8_t *prefix, int prefixLength);
+
+  public:
+    TraceFlowMatch() {}
+    explicit TraceFlowMatch(const cValueMap *conditions, const char *ignoredKey = nullptr);
+
+    bool matches(const TraceFlow& flow) const;
+};
+
+#endif